@@ -0,0 +1,52 @@
+#include <benchmark/benchmark.h>
+#include "../src/concurrent_vocabulary.h"
+#include <string>
+#include <vector>
+
+using namespace std;
+
+static const int WORD_COUNT = 100000;
+
+static ConcurrentVocabulary& sharedVocabulary() {
+    static ConcurrentVocabulary* words = []() {
+        vector<pair<string, string>> pairs;
+        for (int i = 0; i < WORD_COUNT; ++i) {
+            pairs.emplace_back("word" + to_string(i), "слово" + to_string(i));
+        }
+        return new ConcurrentVocabulary(Vocabulary(pairs));
+    }();
+    return *words;
+}
+
+// Пропускная способность чтения в зависимости от числа потоков
+static void BM_ConcurrentRead(benchmark::State& state) {
+    ConcurrentVocabulary& words = sharedVocabulary();
+    vector<string> keys;
+    for (int i = 0; i < 1024; ++i) {
+        keys.push_back("word" + to_string((i * 7919 + state.thread_index() * 104729) % WORD_COUNT));
+    }
+    size_t i = 0;
+    for (auto _ : state) {
+        const string& key = keys[i++ & 1023];
+        bool found = words.read([&key](const Vocabulary& snapshot) { return snapshot.find(key) != nullptr; });
+        benchmark::DoNotOptimize(found);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ConcurrentRead)->ThreadRange(1, 16)->UseRealTime();
+
+// Чтение при работающем писателе в нулевом потоке
+static void BM_ConcurrentReadWithWriter(benchmark::State& state) {
+    ConcurrentVocabulary& words = sharedVocabulary();
+    size_t i = 0;
+    for (auto _ : state) {
+        if (state.thread_index() == 0 && (i & 4095) == 0) {
+            words += {"extra" + to_string(i), "лишнее"};
+            words -= "extra" + to_string(i);
+        }
+        bool found = words.contains("word" + to_string(i++ % WORD_COUNT));
+        benchmark::DoNotOptimize(found);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ConcurrentReadWithWriter)->ThreadRange(1, 16)->UseRealTime();
@@ -0,0 +1,168 @@
+#include <benchmark/benchmark.h>
+#include "../src/vocabulary.h"
+#include "../src/tree.h"
+#include <cmath>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+static const int DICTIONARY_SIZE = 200000;
+
+static const Vocabulary& dictionary() {
+    static Vocabulary* words = []() {
+        vector<pair<string, string>> pairs;
+        for (int i = 0; i < DICTIONARY_SIZE; ++i) {
+            pairs.emplace_back("word" + to_string(i), "слово" + to_string(i));
+        }
+        return new Vocabulary(pairs);
+    }();
+    return *words;
+}
+
+// Корпус с распределением Ципфа: частые слова встречаются намного чаще редких
+struct Corpus {
+    string text;
+    vector<string_view> tokens;
+};
+
+static const Corpus& corpus(size_t tokenCount) {
+    static Corpus* cached = nullptr;
+    if (!cached || cached->tokens.size() != tokenCount) {
+        delete cached;
+        cached = new Corpus;
+        mt19937 generator(42);
+        uniform_real_distribution<double> uniform(0.0, 1.0);
+        vector<size_t> offsets;
+        for (size_t i = 0; i < tokenCount; ++i) {
+            int rank = static_cast<int>(pow(DICTIONARY_SIZE * 1.2, uniform(generator))) - 1;
+            offsets.push_back(cached->text.size());
+            cached->text += "word" + to_string(rank) + " ";
+        }
+        for (size_t i = 0; i < offsets.size(); ++i) {
+            size_t end = cached->text.find(' ', offsets[i]);
+            cached->tokens.emplace_back(cached->text.data() + offsets[i], end - offsets[i]);
+        }
+    }
+    return *cached;
+}
+
+static void BM_TranslatePerToken(benchmark::State& state) {
+    const Vocabulary& words = dictionary();
+    const Corpus& text = corpus(state.range(0));
+    vector<const string*> translations(text.tokens.size());
+    for (auto _ : state) {
+        for (size_t i = 0; i < text.tokens.size(); ++i) {
+            translations[i] = words.find(text.tokens[i]);
+        }
+        benchmark::DoNotOptimize(translations.data());
+    }
+    state.SetItemsProcessed(state.iterations() * text.tokens.size());
+}
+BENCHMARK(BM_TranslatePerToken)->Arg(1 << 20)->Arg(10000000)->Unit(benchmark::kMillisecond);
+
+static void BM_TranslateBatch(benchmark::State& state) {
+    const Vocabulary& words = dictionary();
+    const Corpus& text = corpus(state.range(0));
+    vector<const string*> translations(text.tokens.size());
+    for (auto _ : state) {
+        words.translate(text.tokens.data(), text.tokens.size(), translations.data(), state.range(1));
+        benchmark::DoNotOptimize(translations.data());
+    }
+    state.SetItemsProcessed(state.iterations() * text.tokens.size());
+}
+BENCHMARK(BM_TranslateBatch)->Args({1 << 20, 1})->Args({10000000, 1})->Args({10000000, 4})
+    ->Unit(benchmark::kMillisecond)->UseRealTime();
+
+// Точечный поиск: указательное дерево Tree против арены Vocabulary и индекса Eytzinger
+// Похожие на слова ключи длиной 5-12 букв в случайном порядке
+static string benchKey(size_t i) {
+    uint64_t state = i * 0x9E3779B97F4A7C15ull + 1;
+    string key;
+    size_t length = 5 + state % 8;
+    for (size_t c = 0; c < length; ++c) {
+        state ^= state >> 29;
+        state *= 0xBF58476D1CE4E5B9ull;
+        key += static_cast<char>('a' + (state >> 40) % 26);
+    }
+    return key;
+}
+
+static vector<string> lookupKeys(size_t size) {
+    vector<string> keys;
+    mt19937 generator(7);
+    for (size_t i = 0; i < 4096; ++i) keys.push_back(benchKey(generator() % size));
+    return keys;
+}
+
+static void BM_LookupPointerTree(benchmark::State& state) {
+    size_t size = state.range(0);
+    Tree* root = new Tree(benchKey(0), "перевод");
+    for (size_t i = 1; i < size; ++i) root = root->addNodeBalanced(benchKey(i), "перевод");
+    vector<string> keys = lookupKeys(size);
+    size_t i = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(root->findNode(keys[i++ & 4095]));
+    }
+    state.SetItemsProcessed(state.iterations());
+    delete root;
+}
+BENCHMARK(BM_LookupPointerTree)->Arg(10000)->Arg(1000000)->Arg(10000000);
+
+static void BM_LookupVocabulary(benchmark::State& state) {
+    size_t size = state.range(0);
+    VocabularyBackend backend = static_cast<VocabularyBackend>(state.range(1));
+    Vocabulary words(backend);
+    {
+        vector<pair<string, string>> pairs;
+        pairs.reserve(size);
+        for (size_t i = 0; i < size; ++i) pairs.emplace_back(benchKey(i), "перевод");
+        words.assign(std::move(pairs));
+    }
+    vector<string> keys = lookupKeys(size);
+    size_t i = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(words.find(keys[i++ & 4095]));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_LookupVocabulary)
+    ->ArgsProduct({{10000, 1000000, 10000000},
+                   {static_cast<int>(VocabularyBackend::Tree), static_cast<int>(VocabularyBackend::Eytzinger)}})
+    ->ArgNames({"size", "backend"});
+
+// Слияние дельты в основной словарь: поэлементные += против merge
+static Vocabulary mergeSource(size_t first, size_t count) {
+    vector<pair<string, string>> pairs;
+    pairs.reserve(count);
+    for (size_t i = first; i < first + count; ++i) pairs.emplace_back(benchKey(i), "перевод");
+    return Vocabulary(std::move(pairs));
+}
+
+static void BM_MergeByInsert(benchmark::State& state) {
+    size_t size = state.range(0);
+    Vocabulary delta = mergeSource(size / 2, size);
+    for (auto _ : state) {
+        state.PauseTiming();
+        Vocabulary master = mergeSource(0, size);
+        state.ResumeTiming();
+        for (const Vocabulary::Entry& node : delta) master += {node.english, node.russian};
+        benchmark::DoNotOptimize(master.size());
+    }
+}
+BENCHMARK(BM_MergeByInsert)->Arg(100000)->Arg(1000000)->Unit(benchmark::kMillisecond);
+
+static void BM_Merge(benchmark::State& state) {
+    size_t size = state.range(0);
+    Vocabulary delta = mergeSource(size / 2, size);
+    for (auto _ : state) {
+        state.PauseTiming();
+        Vocabulary master = mergeSource(0, size);
+        state.ResumeTiming();
+        master.merge(delta, ConflictPolicy::KeepExisting, state.range(1));
+        benchmark::DoNotOptimize(master.size());
+    }
+}
+BENCHMARK(BM_Merge)->ArgsProduct({{100000, 1000000}, {1, 4}})->ArgNames({"size", "threads"})
+    ->Unit(benchmark::kMillisecond)->UseRealTime();
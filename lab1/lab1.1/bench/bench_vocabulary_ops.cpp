@@ -0,0 +1,112 @@
+#include <benchmark/benchmark.h>
+#include "../src/vocabulary.h"
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// Базовые операции словаря по размерам и порядку ключей:
+// 0 — по возрастанию, 1 — по убыванию, 2 — случайный
+enum KeyOrder { Ascending, Descending, Shuffled };
+
+static vector<string> orderedKeys(size_t size, int order) {
+    vector<string> keys;
+    keys.reserve(size);
+    char buffer[32];
+    for (size_t i = 0; i < size; ++i) {
+        snprintf(buffer, sizeof(buffer), "key%09zu", i);
+        keys.emplace_back(buffer);
+    }
+    if (order == Descending) {
+        reverse(keys.begin(), keys.end());
+    } else if (order == Shuffled) {
+        shuffle(keys.begin(), keys.end(), mt19937(13));
+    }
+    return keys;
+}
+
+static Vocabulary filledVocabulary(const vector<string>& keys) {
+    Vocabulary words;
+    for (const string& key : keys) {
+        words += make_pair(key, string("перевод"));
+    }
+    return words;
+}
+
+static void orderArgs(benchmark::internal::Benchmark* benchmark) {
+    benchmark->ArgsProduct({{1 << 10, 1 << 14, 1 << 18}, {Ascending, Descending, Shuffled}})
+        ->ArgNames({"size", "order"});
+}
+
+static void BM_VocabularyInsert(benchmark::State& state) {
+    vector<string> keys = orderedKeys(state.range(0), state.range(1));
+    for (auto _ : state) {
+        Vocabulary words = filledVocabulary(keys);
+        benchmark::DoNotOptimize(words.contains(keys[0]));
+    }
+    state.SetItemsProcessed(state.iterations() * keys.size());
+}
+BENCHMARK(BM_VocabularyInsert)->Apply(orderArgs)->Unit(benchmark::kMillisecond);
+
+// Дерево построено вставками в заданном порядке, ключи ищутся вперемешку
+static void BM_VocabularyLookup(benchmark::State& state) {
+    vector<string> keys = orderedKeys(state.range(0), state.range(1));
+    Vocabulary words = filledVocabulary(keys);
+    vector<string> probes = keys;
+    shuffle(probes.begin(), probes.end(), mt19937(29));
+    probes.resize(min<size_t>(probes.size(), 4096));
+    size_t i = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(words.find(probes[i++ % probes.size()]));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_VocabularyLookup)->Apply(orderArgs);
+
+static void BM_VocabularyDelete(benchmark::State& state) {
+    vector<string> keys = orderedKeys(state.range(0), state.range(1));
+    Vocabulary filled = filledVocabulary(keys);
+    for (auto _ : state) {
+        state.PauseTiming();
+        Vocabulary words = filled;
+        state.ResumeTiming();
+        for (const string& key : keys) {
+            words -= key;
+        }
+        benchmark::DoNotOptimize(words.contains(keys[0]));
+    }
+    state.SetItemsProcessed(state.iterations() * keys.size());
+}
+BENCHMARK(BM_VocabularyDelete)->Apply(orderArgs)->Unit(benchmark::kMillisecond);
+
+static void formatArgs(benchmark::internal::Benchmark* benchmark) {
+    benchmark->ArgsProduct({{1 << 10, 1 << 14, 1 << 18},
+                            {static_cast<int>(VocabularyFormat::Text), static_cast<int>(VocabularyFormat::Binary)}})
+        ->ArgNames({"size", "format"});
+}
+
+static void BM_VocabularySave(benchmark::State& state) {
+    Vocabulary words = filledVocabulary(orderedKeys(state.range(0), Shuffled));
+    VocabularyFormat format = static_cast<VocabularyFormat>(state.range(1));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(words.saveToFile("bench_vocabulary.dat", format));
+    }
+    remove("bench_vocabulary.dat");
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_VocabularySave)->Apply(formatArgs)->UseRealTime()->Unit(benchmark::kMillisecond);
+
+static void BM_VocabularyLoad(benchmark::State& state) {
+    filledVocabulary(orderedKeys(state.range(0), Shuffled))
+        .saveToFile("bench_vocabulary.dat", static_cast<VocabularyFormat>(state.range(1)));
+    for (auto _ : state) {
+        Vocabulary words;
+        benchmark::DoNotOptimize(words.loadFromFile("bench_vocabulary.dat"));
+    }
+    remove("bench_vocabulary.dat");
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_VocabularyLoad)->Apply(formatArgs)->UseRealTime()->Unit(benchmark::kMillisecond);
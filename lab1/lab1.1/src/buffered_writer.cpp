@@ -0,0 +1,153 @@
+#include "buffered_writer.h"
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+struct Crc32Table{
+    uint32_t values[256];
+    Crc32Table(){
+        for(uint32_t i = 0; i < 256; ++i){
+            uint32_t crc = i;
+            for(int bit = 0; bit < 8; ++bit){
+                crc = (crc & 1) ? (crc >> 1) ^ 0xEDB88320u : crc >> 1;
+            }
+            values[i] = crc;
+        }
+    }
+};
+
+// rename становится долговечным только после fsync каталога
+bool syncDirectory(const string& filename){
+    size_t slash = filename.rfind('/');
+    string directory = slash == string::npos ? "." : slash == 0 ? "/" : filename.substr(0, slash);
+    int fd = ::open(directory.c_str(), O_RDONLY | O_DIRECTORY);
+    if(fd < 0) return false;
+    bool ok = fsync(fd) == 0;
+    return ::close(fd) == 0 && ok;
+}
+
+}
+
+uint32_t crc32(const char* data, size_t length, uint32_t crc){
+    static const Crc32Table table;
+    crc = ~crc;
+    for(size_t i = 0; i < length; ++i){
+        crc = table.values[(crc ^ static_cast<unsigned char>(data[i])) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+BufferedWriter::BufferedWriter(size_t bufferSize)
+    : buffer_(bufferSize ? bufferSize : 1), used_(0), fd_(-1), failed_(false){}
+
+BufferedWriter::~BufferedWriter(){
+    abort();
+}
+
+// Временный файл получает уникальное имя "<имя>.XXXXXX" в каталоге целевого:
+// чужие файлы не затираются, а одновременные сохранения пишут в разные файлы.
+// Права копируются с целевого файла, новый получает те же 0644, что и без atomic
+bool BufferedWriter::open(const string& filename, bool atomic){
+    abort();
+    filename_ = filename;
+    used_ = 0;
+    if(!atomic){
+        writtenName_ = filename;
+        fd_ = ::open(writtenName_.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        failed_ = fd_ < 0;
+        return !failed_;
+    }
+    string pattern = filename + ".XXXXXX";
+    fd_ = mkstemp(&pattern[0]);
+    failed_ = fd_ < 0;
+    if(failed_) return false;
+    writtenName_ = pattern;
+    struct stat target;
+    mode_t mode = ::stat(filename.c_str(), &target) == 0 ? target.st_mode & 07777 : 0644;
+    if(fchmod(fd_, mode) != 0){
+        abort();
+        failed_ = true;
+        return false;
+    }
+    return true;
+}
+
+const string& BufferedWriter::temporaryName() const{
+    return writtenName_;
+}
+
+// Прерванный сигналом write (EINTR) повторяется, ошибкой считаются только остальные
+bool BufferedWriter::flushBuffer(){
+    size_t written = 0;
+    while(!failed_ && written < used_){
+        ssize_t result = ::write(fd_, buffer_.data() + written, used_ - written);
+        if(result >= 0) written += static_cast<size_t>(result);
+        else if(errno != EINTR) failed_ = true;
+    }
+    used_ = 0;
+    return !failed_;
+}
+
+void BufferedWriter::write(const char* data, size_t length){
+    if(fd_ < 0) return;
+    if(used_ + length > buffer_.size()){
+        flushBuffer();
+        if(length > buffer_.size()){
+            used_ = 0;
+            while(!failed_ && length > 0){
+                ssize_t result = ::write(fd_, data, length);
+                if(result >= 0){
+                    data += result;
+                    length -= static_cast<size_t>(result);
+                } else if(errno != EINTR) failed_ = true;
+            }
+            return;
+        }
+    }
+    memcpy(buffer_.data() + used_, data, length);
+    used_ += length;
+}
+
+void BufferedWriter::write(string_view text){
+    write(text.data(), text.size());
+}
+
+void BufferedWriter::put(char symbol){
+    if(used_ == buffer_.size()) flushBuffer();
+    buffer_[used_++] = symbol;
+}
+
+bool BufferedWriter::commit(){
+    if(fd_ < 0) return false;
+    bool ok = flushBuffer() && fsync(fd_) == 0;
+    ok = ::close(fd_) == 0 && ok;
+    fd_ = -1;
+    if(ok && writtenName_ != filename_){
+        ok = rename(writtenName_.c_str(), filename_.c_str()) == 0 && syncDirectory(filename_);
+    }
+    if(!ok && writtenName_ != filename_){
+        remove(writtenName_.c_str());
+    }
+    writtenName_.clear();
+    return ok;
+}
+
+// Незавершенная атомарная запись не трогает целевой файл
+void BufferedWriter::abort(){
+    if(fd_ >= 0){
+        ::close(fd_);
+        fd_ = -1;
+        if(writtenName_ != filename_) remove(writtenName_.c_str());
+    }
+    used_ = 0;
+    writtenName_.clear();
+}
+
+bool BufferedWriter::isOpen() const{
+    return fd_ >= 0;
+}
@@ -0,0 +1,44 @@
+#ifndef BUFFERED_WRITER_H
+#define BUFFERED_WRITER_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+using namespace std;
+
+uint32_t crc32(const char* data, size_t length, uint32_t crc = 0);
+
+// Запись файла через большой буфер в памяти: системный вызов write делается
+// только при заполнении буфера. В атомарном режиме данные пишутся во временный
+// файл с уникальным именем рядом с целевым, который после fsync заменяет
+// целевой через rename (с fsync каталога), так что при сбое на диске остается
+// либо старый файл, либо новый целиком.
+class BufferedWriter{
+    private:
+    vector<char> buffer_;
+    size_t used_;
+    int fd_;
+    bool failed_;
+    string filename_;
+    string writtenName_;
+    bool flushBuffer();
+    public:
+    explicit BufferedWriter(size_t bufferSize = 1 << 20);
+    BufferedWriter(const BufferedWriter&) = delete;
+    BufferedWriter& operator=(const BufferedWriter&) = delete;
+    ~BufferedWriter();
+    bool open(const string& filename, bool atomic = true);
+    void write(const char* data, size_t length);
+    void write(string_view text);
+    void put(char symbol);
+    bool commit();
+    void abort();
+    bool isOpen() const;
+    // Файл, в который сейчас идет запись: временный в атомарном режиме
+    const string& temporaryName() const;
+};
+
+#endif
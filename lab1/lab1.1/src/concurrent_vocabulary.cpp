@@ -0,0 +1,134 @@
+#include "concurrent_vocabulary.h"
+#include <functional>
+#include <thread>
+
+namespace {
+
+size_t readerSlotIndex(size_t slots){
+    thread_local size_t index = hash<thread::id>()(this_thread::get_id());
+    return index % slots;
+}
+
+}
+
+ConcurrentVocabulary::ReadGuard::ReadGuard(const ConcurrentVocabulary& owner)
+    : owner_(owner), ticket_(owner.enterRead()), vocabulary(owner.current_.load()){}
+
+ConcurrentVocabulary::ReadGuard::~ReadGuard(){
+    owner_.leaveRead(ticket_);
+}
+
+ConcurrentVocabulary::ConcurrentVocabulary(size_t batchSize)
+    : ConcurrentVocabulary(Vocabulary(), batchSize){}
+
+ConcurrentVocabulary::ConcurrentVocabulary(const Vocabulary& initial, size_t batchSize)
+    : current_(nullptr), epoch_(0), batchSize_(batchSize ? batchSize : 1){
+    // Кэш частых слов меняется при чтении, поэтому в общих снимках он выключен
+    Vocabulary* first = new Vocabulary(initial);
+    first->setCacheCapacity(0);
+    first->reindex();
+    current_.store(first);
+    for(ReaderSlot& slot : readers_){
+        slot.active[0].store(0);
+        slot.active[1].store(0);
+    }
+}
+
+ConcurrentVocabulary::~ConcurrentVocabulary(){
+    delete current_.load();
+}
+
+// Читатель отмечается в счетчике своей четности; счетчики разнесены по
+// строкам кэша, чтобы потоки-читатели не конкурировали за одну ячейку
+size_t ConcurrentVocabulary::enterRead() const{
+    size_t slot = readerSlotIndex(READER_SLOTS);
+    size_t parity = epoch_.load() & 1;
+    readers_[slot].active[parity].fetch_add(1);
+    return slot * 2 + parity;
+}
+
+void ConcurrentVocabulary::leaveRead(size_t ticket) const{
+    readers_[ticket / 2].active[ticket % 2].fetch_sub(1);
+}
+
+// Два переключения эпохи: читатель, прочитавший эпоху до первого
+// переключения и отметившийся позже, будет учтен при втором
+void ConcurrentVocabulary::waitForReaders(){
+    for(int flip = 0; flip < 2; ++flip){
+        size_t parity = epoch_.fetch_add(1) & 1;
+        for(ReaderSlot& slot : readers_){
+            while(slot.active[parity].load() != 0){
+                this_thread::yield();
+            }
+        }
+    }
+}
+
+void ConcurrentVocabulary::flushLocked(){
+    if(pending_.empty()){
+        return;
+    }
+    Vocabulary* next = new Vocabulary(*current_.load());
+    for(PendingChange& change : pending_){
+        if(change.remove) *next -= change.english;
+        else *next += make_pair(std::move(change.english), std::move(change.russian));
+    }
+    pending_.clear();
+    next->reindex();
+    const Vocabulary* previous = current_.exchange(next);
+    waitForReaders();
+    delete previous;
+}
+
+void ConcurrentVocabulary::enqueue(PendingChange change){
+    lock_guard<mutex> lock(writerMutex_);
+    pending_.push_back(std::move(change));
+    if(pending_.size() >= batchSize_){
+        flushLocked();
+    }
+}
+
+bool ConcurrentVocabulary::find(string_view english, string& russian) const{
+    ReadGuard guard(*this);
+    const string* found = guard.vocabulary->find(english);
+    if(!found){
+        return false;
+    }
+    russian.assign(*found);
+    return true;
+}
+
+bool ConcurrentVocabulary::contains(string_view english) const{
+    ReadGuard guard(*this);
+    return guard.vocabulary->contains(english);
+}
+
+size_t ConcurrentVocabulary::size() const{
+    ReadGuard guard(*this);
+    return guard.vocabulary->size();
+}
+
+Vocabulary ConcurrentVocabulary::snapshot() const{
+    ReadGuard guard(*this);
+    return *guard.vocabulary;
+}
+
+ConcurrentVocabulary& ConcurrentVocabulary::operator+=(const pair<string, string>& pairWords){
+    enqueue(PendingChange{false, pairWords.first, pairWords.second});
+    return *this;
+}
+
+ConcurrentVocabulary& ConcurrentVocabulary::operator-=(const string& english){
+    enqueue(PendingChange{true, english, ""});
+    return *this;
+}
+
+void ConcurrentVocabulary::flush(){
+    lock_guard<mutex> lock(writerMutex_);
+    flushLocked();
+}
+
+size_t ConcurrentVocabulary::pendingCount() const{
+    lock_guard<mutex> lock(writerMutex_);
+    return pending_.size();
+}
@@ -0,0 +1,75 @@
+#ifndef CONCURRENT_VOCABULARY_H
+#define CONCURRENT_VOCABULARY_H
+
+#include "vocabulary.h"
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <utility>
+
+using namespace std;
+
+// Словарь для многопоточного чтения с редкими изменениями.
+// Читатели берут текущий снимок через атомарный указатель и никогда не ждут.
+// Писатель копирует снимок, применяет накопленный пакет изменений, публикует
+// новый снимок и освобождает старый, дождавшись ухода всех его читателей (RCU).
+class ConcurrentVocabulary{
+    private:
+    static const size_t READER_SLOTS = 64;
+    struct alignas(64) ReaderSlot{
+        atomic<size_t> active[2];
+    };
+    struct PendingChange{
+        bool remove;
+        string english;
+        string russian;
+    };
+    class ReadGuard{
+        private:
+        const ConcurrentVocabulary& owner_;
+        size_t ticket_;
+        public:
+        const Vocabulary* vocabulary;
+        explicit ReadGuard(const ConcurrentVocabulary& owner);
+        ReadGuard(const ReadGuard&) = delete;
+        ReadGuard& operator=(const ReadGuard&) = delete;
+        ~ReadGuard();
+    };
+    atomic<const Vocabulary*> current_;
+    atomic<size_t> epoch_;
+    mutable ReaderSlot readers_[READER_SLOTS];
+    mutable mutex writerMutex_;
+    vector<PendingChange> pending_;
+    size_t batchSize_;
+    size_t enterRead() const;
+    void leaveRead(size_t ticket) const;
+    void waitForReaders();
+    void flushLocked();
+    void enqueue(PendingChange change);
+    public:
+    explicit ConcurrentVocabulary(size_t batchSize = 1);
+    explicit ConcurrentVocabulary(const Vocabulary& initial, size_t batchSize = 1);
+    ConcurrentVocabulary(const ConcurrentVocabulary&) = delete;
+    ConcurrentVocabulary& operator=(const ConcurrentVocabulary&) = delete;
+    ~ConcurrentVocabulary();
+    template <typename Reader>
+    auto read(Reader reader) const -> decltype(reader(declval<const Vocabulary&>()));
+    bool find(string_view english, string& russian) const;
+    bool contains(string_view english) const;
+    size_t size() const;
+    Vocabulary snapshot() const;
+    ConcurrentVocabulary& operator+=(const pair<string, string>& pairWords);
+    ConcurrentVocabulary& operator-=(const string& english);
+    void flush();
+    size_t pendingCount() const;
+};
+
+template <typename Reader>
+auto ConcurrentVocabulary::read(Reader reader) const -> decltype(reader(declval<const Vocabulary&>())){
+    ReadGuard guard(*this);
+    return reader(*guard.vocabulary);
+}
+
+#endif
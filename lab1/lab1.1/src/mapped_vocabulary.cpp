@@ -0,0 +1,161 @@
+#include "mapped_vocabulary.h"
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <fstream>
+
+MappedVocabulary::MappedVocabulary()
+    : data_(nullptr), length_(0), entries_(nullptr), strings_(nullptr), stringsLength_(0), count_(0){}
+
+MappedVocabulary::MappedVocabulary(MappedVocabulary&& moved) noexcept
+    : data_(moved.data_), length_(moved.length_), entries_(moved.entries_),
+      strings_(moved.strings_), stringsLength_(moved.stringsLength_), count_(moved.count_){
+    moved.data_ = nullptr;
+    moved.length_ = 0;
+    moved.entries_ = nullptr;
+    moved.strings_ = nullptr;
+    moved.stringsLength_ = 0;
+    moved.count_ = 0;
+}
+
+MappedVocabulary::~MappedVocabulary(){
+    close();
+}
+
+MappedVocabulary& MappedVocabulary::operator=(MappedVocabulary&& other) noexcept{
+    if(this != &other){
+        close();
+        data_ = other.data_;
+        length_ = other.length_;
+        entries_ = other.entries_;
+        strings_ = other.strings_;
+        stringsLength_ = other.stringsLength_;
+        count_ = other.count_;
+        other.data_ = nullptr;
+        other.length_ = 0;
+        other.entries_ = nullptr;
+        other.strings_ = nullptr;
+        other.stringsLength_ = 0;
+        other.count_ = 0;
+    }
+    return *this;
+}
+
+bool MappedVocabulary::open(const string& filename){
+    close();
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if(fd < 0){
+        return false;
+    }
+    struct stat info;
+    if(fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < sizeof(VocabularyFileHeader)){
+        ::close(fd);
+        return false;
+    }
+    size_t length = static_cast<size_t>(info.st_size);
+    void* mapped = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if(mapped == MAP_FAILED){
+        return false;
+    }
+
+    const char* data = static_cast<const char*>(mapped);
+    VocabularyFileHeader header;
+    memcpy(&header, data, sizeof(header));
+    bool valid = memcmp(header.magic, VOCABULARY_FILE_MAGIC, sizeof(header.magic)) == 0 &&
+                 header.version == VOCABULARY_FILE_VERSION &&
+                 header.count <= (length - sizeof(header)) / sizeof(VocabularyFileEntry);
+    if(!valid){
+        munmap(mapped, length);
+        return false;
+    }
+    data_ = data;
+    length_ = length;
+    entries_ = reinterpret_cast<const VocabularyFileEntry*>(data + sizeof(header));
+    strings_ = data + sizeof(header) + header.count * sizeof(VocabularyFileEntry);
+    stringsLength_ = length - (strings_ - data);
+    count_ = header.count;
+    return true;
+}
+
+void MappedVocabulary::close(){
+    if(data_){
+        munmap(const_cast<char*>(data_), length_);
+    }
+    data_ = nullptr;
+    length_ = 0;
+    entries_ = nullptr;
+    strings_ = nullptr;
+    stringsLength_ = 0;
+    count_ = 0;
+}
+
+bool MappedVocabulary::isOpen() const{
+    return data_ != nullptr;
+}
+
+size_t MappedVocabulary::size() const{
+    return count_;
+}
+
+// Смещения проверяются при обращении, а не при открытии,
+// чтобы открытие большого файла не читало всю таблицу записей
+string_view MappedVocabulary::stringAt(uint32_t offset, uint32_t length) const{
+    if(uint64_t(offset) + length > stringsLength_){
+        return string_view();
+    }
+    return string_view(strings_ + offset, length);
+}
+
+string_view MappedVocabulary::englishAt(size_t index) const{
+    const VocabularyFileEntry& entry = entries_[index];
+    return stringAt(entry.englishOffset, entry.englishLength);
+}
+
+string_view MappedVocabulary::russianAt(size_t index) const{
+    const VocabularyFileEntry& entry = entries_[index];
+    return stringAt(entry.russianOffset, entry.russianLength);
+}
+
+bool MappedVocabulary::entryValid(size_t index) const{
+    const VocabularyFileEntry& entry = entries_[index];
+    return uint64_t(entry.englishOffset) + entry.englishLength <= stringsLength_ &&
+           uint64_t(entry.russianOffset) + entry.russianLength <= stringsLength_;
+}
+
+bool MappedVocabulary::find(string_view english, string_view& russian) const{
+    size_t low = 0;
+    size_t high = count_;
+    while(low < high){
+        size_t middle = low + (high - low) / 2;
+        int compared = englishAt(middle).compare(english);
+        if(compared < 0) low = middle + 1;
+        else if(compared > 0) high = middle;
+        else {
+            russian = russianAt(middle);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool MappedVocabulary::contains(string_view english) const{
+    string_view russian;
+    return find(english, russian);
+}
+
+string MappedVocabulary::operator[](const string& english) const{
+    string_view russian;
+    return find(english, russian) ? string(russian) : "";
+}
+
+bool MappedVocabulary::isBinaryFile(const string& filename){
+    ifstream file(filename, ios::binary);
+    char magic[sizeof(VOCABULARY_FILE_MAGIC)];
+    if(!file.read(magic, sizeof(magic))){
+        return false;
+    }
+    return memcmp(magic, VOCABULARY_FILE_MAGIC, sizeof(magic)) == 0;
+}
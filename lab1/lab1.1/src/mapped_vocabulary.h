@@ -0,0 +1,63 @@
+#ifndef MAPPED_VOCABULARY_H
+#define MAPPED_VOCABULARY_H
+
+#include <string>
+#include <string_view>
+#include <cstdint>
+#include <cstddef>
+
+using namespace std;
+
+// Двоичный формат словаря (версия 1):
+// заголовок, таблица записей, отсортированная по английскому слову, и общий блок строк.
+// Смещения в записях отсчитываются от начала блока строк.
+struct VocabularyFileHeader{
+    char magic[4];
+    uint32_t version;
+    uint64_t count;
+};
+
+struct VocabularyFileEntry{
+    uint32_t englishOffset;
+    uint32_t englishLength;
+    uint32_t russianOffset;
+    uint32_t russianLength;
+};
+
+const char VOCABULARY_FILE_MAGIC[4] = {'V', 'O', 'C', 'B'};
+const uint32_t VOCABULARY_FILE_VERSION = 1;
+
+// Словарь только для чтения поверх отображенного в память двоичного файла.
+// Поиск идет двоичным поиском прямо по таблице записей, дерево не строится.
+class MappedVocabulary{
+    private:
+    const char* data_;
+    size_t length_;
+    const VocabularyFileEntry* entries_;
+    const char* strings_;
+    size_t stringsLength_;
+    size_t count_;
+    string_view stringAt(uint32_t offset, uint32_t length) const;
+    public:
+    MappedVocabulary();
+    MappedVocabulary(const MappedVocabulary&) = delete;
+    MappedVocabulary(MappedVocabulary&& moved) noexcept;
+    ~MappedVocabulary();
+    MappedVocabulary& operator=(const MappedVocabulary&) = delete;
+    MappedVocabulary& operator=(MappedVocabulary&& other) noexcept;
+    bool open(const string& filename);
+    void close();
+    bool isOpen() const;
+    size_t size() const;
+    string_view englishAt(size_t index) const;
+    string_view russianAt(size_t index) const;
+    // true, если обе строки записи лежат внутри блока строк; иначе englishAt
+    // и russianAt вернут пустые строки
+    bool entryValid(size_t index) const;
+    bool find(string_view english, string_view& russian) const;
+    bool contains(string_view english) const;
+    string operator[](const string& english) const;
+    static bool isBinaryFile(const string& filename);
+};
+
+#endif
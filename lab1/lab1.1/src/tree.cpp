@@ -1,23 +1,51 @@
 #include "tree.h"
 
 Tree::Tree(const string& english, const string& russian)
-:english_(english), russian_(russian),left_(nullptr),right_(nullptr){}
+:english_(english), russian_(russian),left_(nullptr),right_(nullptr),height_(1){}
 
+// Копирование и удаление идут по явному стеку: глубина вырожденного
+// дерева не ограничена стеком вызовов
 Tree::Tree(const Tree& copiedTree)
-:english_(copiedTree.english_), russian_(copiedTree.russian_),
-left_(copiedTree.left_ ? new Tree(*copiedTree.left_) : nullptr),
-right_(copiedTree.right_ ? new Tree(*copiedTree.right_) : nullptr){}
+:english_(copiedTree.english_), russian_(copiedTree.russian_),left_(nullptr),right_(nullptr),
+height_(copiedTree.height_){
+    vector<pair<const Tree*, Tree*>> pending{{&copiedTree, this}};
+    while(!pending.empty()){
+        const Tree* source = pending.back().first;
+        Tree* copy = pending.back().second;
+        pending.pop_back();
+        if(source->left_){
+            copy->left_ = new Tree(source->left_->english_, source->left_->russian_);
+            copy->left_->height_ = source->left_->height_;
+            pending.emplace_back(source->left_, copy->left_);
+        }
+        if(source->right_){
+            copy->right_ = new Tree(source->right_->english_, source->right_->russian_);
+            copy->right_->height_ = source->right_->height_;
+            pending.emplace_back(source->right_, copy->right_);
+        }
+    }
+}
 
 Tree::~Tree(){
-    delete left_;
-    delete right_;
+    vector<Tree*> pending;
+    if(left_) pending.push_back(left_);
+    if(right_) pending.push_back(right_);
+    while(!pending.empty()){
+        Tree* node = pending.back();
+        pending.pop_back();
+        if(node->left_) pending.push_back(node->left_);
+        if(node->right_) pending.push_back(node->right_);
+        node->left_ = nullptr;
+        node->right_ = nullptr;
+        delete node;
+    }
 }
 
-string Tree::getEnglish() const{
+const string& Tree::getEnglish() const{
     return english_;
 }
 
-string Tree::getRussian() const{
+const string& Tree::getRussian() const{
     return russian_;
 }
 
@@ -29,6 +57,10 @@ Tree* Tree::getRight() const{
     return right_;
 }
 
+int Tree::getHeight() const{
+    return height_;
+}
+
 void Tree::setEnglish(const string& english){
     english_ = english;
 }
@@ -39,10 +71,50 @@ void Tree::setRussian(const string& russian){
 
 void Tree::setLeft(Tree* left){
     left_ = left;
+    updateHeight();
 }
 
 void Tree::setRight(Tree* right){
     right_ = right;
+    updateHeight();
+}
+
+void Tree::updateHeight(){
+    int leftHeight = left_ ? left_->height_ : 0;
+    int rightHeight = right_ ? right_->height_ : 0;
+    height_ = 1 + (leftHeight > rightHeight ? leftHeight : rightHeight);
+}
+
+int Tree::balanceFactor() const{
+    return (left_ ? left_->height_ : 0) - (right_ ? right_->height_ : 0);
+}
+
+Tree* Tree::rotateLeft(){
+    Tree* newRoot = getRight();
+    setRight(newRoot->getLeft());
+    newRoot->setLeft(this);
+    return newRoot;
+}
+
+Tree* Tree::rotateRight(){
+    Tree* newRoot = getLeft();
+    setLeft(newRoot->getRight());
+    newRoot->setRight(this);
+    return newRoot;
+}
+
+Tree* Tree::rebalance(){
+    updateHeight();
+    int balance = balanceFactor();
+    if(balance > 1){
+        if(getLeft()->balanceFactor() < 0) setLeft(getLeft()->rotateLeft());
+        return rotateRight();
+    }
+    if(balance < -1){
+        if(getRight()->balanceFactor() > 0) setRight(getRight()->rotateRight());
+        return rotateLeft();
+    }
+    return this;
 }
 
 bool Tree::addNodeTree(const string& english, const string& russian){
@@ -52,7 +124,9 @@ bool Tree::addNodeTree(const string& english, const string& russian){
             setLeft(left);
             return true;
         } else {
-            return getLeft()->addNodeTree(english,russian);
+            bool added = getLeft()->addNodeTree(english,russian);
+            updateHeight();
+            return added;
         }
     } else {
         if(!getRight()){
@@ -60,7 +134,9 @@ bool Tree::addNodeTree(const string& english, const string& russian){
             setRight(right);
             return true;
         } else {
-            return getRight()->addNodeTree(english,russian);
+            bool added = getRight()->addNodeTree(english,russian);
+            updateHeight();
+            return added;
         }
     }
     return false;   
@@ -96,40 +172,89 @@ Tree* Tree::deleteNodeTree(const string& english){
             }
         }
     }
+    updateHeight();
     return this;
 }
-Tree* Tree::findNode(const string& english){
-    if(getEnglish() == english) return this;
-    if(english < getEnglish()) return getLeft() ? getLeft()->findNode(english) : nullptr;
-    else return getRight() ? getRight()->findNode(english) : nullptr;
+
+Tree* Tree::addNodeBalanced(const string& english, const string& russian){
+    if(english < getEnglish()){
+        setLeft(getLeft() ? getLeft()->addNodeBalanced(english, russian) : new Tree(english, russian));
+    } else if(english > getEnglish()){
+        setRight(getRight() ? getRight()->addNodeBalanced(english, russian) : new Tree(english, russian));
+    } else {
+        return this;
+    }
+    return rebalance();
 }
 
-const Tree* Tree::findNode(const string& english) const {
-    if(getEnglish() == english) return this;
-    if(english < getEnglish()) return getLeft() ? getLeft()->findNode(english) : nullptr;
-    else return getRight() ? getRight()->findNode(english) : nullptr;
+Tree* Tree::deleteNodeBalanced(const string& english){
+    if(english < getEnglish()){
+        if(getLeft()) setLeft(getLeft()->deleteNodeBalanced(english));
+    } else if(english > getEnglish()){
+        if(getRight()) setRight(getRight()->deleteNodeBalanced(english));
+    } else {
+        if(!getLeft() || !getRight()){
+            Tree* child = getLeft() ? getLeft() : getRight();
+            left_ = nullptr;
+            right_ = nullptr;
+            delete this;
+            return child;
+        }
+        Tree* minNode = getRight();
+        while(minNode->getLeft()) minNode = minNode->getLeft();
+        string en = minNode->getEnglish();
+        setEnglish(en);
+        setRussian(minNode->getRussian());
+        setRight(getRight()->deleteNodeBalanced(en));
+    }
+    return rebalance();
+}
+Tree* Tree::findNode(string_view english){
+    return const_cast<Tree*>(static_cast<const Tree*>(this)->findNode(english));
+}
+
+const Tree* Tree::findNode(string_view english) const {
+    const Tree* current = this;
+    while(current){
+        int compared = english.compare(current->english_);
+        if(compared == 0) return current;
+        current = compared < 0 ? current->left_ : current->right_;
+    }
+    return nullptr;
 }
 
 int Tree::countNodeTree() const{
-    int countLeft = getLeft() ? getLeft()->countNodeTree() : 0;
-    int countRight = getRight() ? getRight()->countNodeTree() : 0;
-    return 1 + countLeft + countRight;
+    int count = 0;
+    vector<const Tree*> pending{this};
+    while(!pending.empty()){
+        const Tree* node = pending.back();
+        pending.pop_back();
+        ++count;
+        if(node->left_) pending.push_back(node->left_);
+        if(node->right_) pending.push_back(node->right_);
+    }
+    return count;
 }
 
 void Tree::printTree(ostream& out) const {
-    if(getLeft()) getLeft()->printTree(out);
-    out << getEnglish() << " - " << getRussian() << "\n";
-    if(getRight()) getRight()->printTree(out);
-
-} 
+    visitInOrder([&out](const Tree& node) {
+        out << node.getEnglish() << " - " << node.getRussian() << "\n";
+    });
+}
 
 bool Tree::operator==(const Tree& other) const{
-    if(getRussian() != other.getRussian() || getEnglish() != other.getEnglish()) return false;
-    bool leftTree = (getLeft() == nullptr && other.getLeft() == nullptr) ||
-                    (getLeft() != nullptr && other.getLeft() != nullptr && *getLeft() == *other.getLeft());
-    bool rightTree = (getRight() == nullptr && other.getRight() == nullptr) ||
-                     (getRight() != nullptr && other.getRight() != nullptr && *getRight() == *other.getRight());
-    return leftTree && rightTree;
+    vector<pair<const Tree*, const Tree*>> pending{{this, &other}};
+    while(!pending.empty()){
+        const Tree* first = pending.back().first;
+        const Tree* second = pending.back().second;
+        pending.pop_back();
+        if(first->russian_ != second->russian_ || first->english_ != second->english_) return false;
+        if((first->left_ == nullptr) != (second->left_ == nullptr)) return false;
+        if((first->right_ == nullptr) != (second->right_ == nullptr)) return false;
+        if(first->left_) pending.emplace_back(first->left_, second->left_);
+        if(first->right_) pending.emplace_back(first->right_, second->right_);
+    }
+    return true;
 }
 
 bool Tree::saveToFile(const string& filename) const {
@@ -143,11 +268,7 @@ bool Tree::saveToFile(const string& filename) const {
 }
 
 void Tree::saveToOut(ostream& out) const {
-    if (getLeft()) {
-        getLeft()->saveToOut(out);
-    }
-    out << getEnglish() << " " << getRussian() << endl;
-    if (getRight()) {
-        getRight()->saveToOut(out);
-    }
+    visitInOrder([&out](const Tree& node) {
+        out << node.getEnglish() << " " << node.getRussian() << "\n";
+    });
 }
\ No newline at end of file
@@ -3,6 +3,9 @@
 #include <iostream>
 #include <fstream>
 #include <string>
+#include <string_view>
+#include <vector>
+#include <utility>
 
 using namespace std;
 
@@ -12,22 +15,34 @@ class Tree{
     string russian_;
     Tree* left_;
     Tree* right_;
+    int height_;
+    void updateHeight();
+    int balanceFactor() const;
+    Tree* rotateLeft();
+    Tree* rotateRight();
+    Tree* rebalance();
+    template <typename Visitor>
+    void visitInOrder(Visitor visit) const;
     public:
     Tree(const string& english, const string& russian);
     Tree(const Tree& copiedTree);
     ~Tree();
-    string getEnglish() const;
-    string getRussian() const;
+    const string& getEnglish() const;
+    const string& getRussian() const;
     Tree* getLeft() const;
     Tree* getRight() const;
+    int getHeight() const;
     void setEnglish(const string& english);
     void setRussian(const string& russian);
     void setLeft(Tree* left);
     void setRight(Tree* right);
     bool addNodeTree(const string& english, const string& russian);
     Tree* deleteNodeTree(const string& english);
-    Tree* findNode(const string& english);
-    const Tree* findNode(const string& english) const;
+    // АВЛ-вставка и удаление: возвращают новый корень поддерева
+    Tree* addNodeBalanced(const string& english, const string& russian);
+    Tree* deleteNodeBalanced(const string& english);
+    Tree* findNode(string_view english);
+    const Tree* findNode(string_view english) const;
     int countNodeTree() const;
     void printTree(ostream& out) const;
     bool operator==(const Tree& other) const;
@@ -36,5 +51,20 @@ class Tree{
 
 };
 
+template <typename Visitor>
+void Tree::visitInOrder(Visitor visit) const{
+    vector<const Tree*> path;
+    const Tree* current = this;
+    while(current || !path.empty()){
+        while(current){
+            path.push_back(current);
+            current = current->left_;
+        }
+        current = path.back();
+        path.pop_back();
+        visit(*current);
+        current = current->right_;
+    }
+}
 
 #endif
\ No newline at end of file
@@ -1,65 +1,733 @@
 #include "vocabulary.h"
-#include "tree.h"
+#include "mapped_vocabulary.h"
+#include "buffered_writer.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <numeric>
+#include <thread>
 
-Vocabulary::Vocabulary() : root_(nullptr){}
+Vocabulary::Vocabulary() : Vocabulary(VocabularyBackend::Tree){}
 
-Vocabulary::Vocabulary(const Vocabulary& copiedVocabulary) 
-    : root_(copiedVocabulary.root_ ? new Tree(*copiedVocabulary.root_) : nullptr) {}
+Vocabulary::Vocabulary(VocabularyBackend backend)
+    : root_(NIL), freeList_(NIL), size_(0), backend_(backend), indexStale_(true), staleLookups_(0),
+      cacheHits_(0), cacheMisses_(0), cacheEvictions_(0){}
 
-Vocabulary::~Vocabulary(){
-    delete root_;
+Vocabulary::Vocabulary(vector<pair<string, string>> pairs, VocabularyBackend backend) : Vocabulary(backend) {
+    assign(std::move(pairs));
 }
 
-Tree* Vocabulary::getRoot() const {
-    return root_;
+size_t Vocabulary::size() const {
+    return size_;
 }
- 
-void Vocabulary::setRoot(Tree* root){
-    root_ = root;
+
+bool Vocabulary::empty() const {
+    return root_ == NIL;
+}
+
+int Vocabulary::height() const {
+    return heightOf(root_);
 }
 
-Vocabulary& Vocabulary::operator=(const Vocabulary& other){
-    if(this != &other) {
-        delete getRoot();
-        setRoot(other.getRoot() ? new Tree(*other.getRoot()) : nullptr);
+size_t Vocabulary::memoryUsage() const {
+    const size_t inlineCapacity = string().capacity();
+    size_t bytes = nodes_.capacity() * sizeof(Node) + index_.capacity() * sizeof(IndexEntry);
+    for (const Node& node : nodes_) {
+        if (node.english.capacity() > inlineCapacity) bytes += node.english.capacity() + 1;
+        if (node.russian.capacity() > inlineCapacity) bytes += node.russian.capacity() + 1;
     }
-    return *this;
+    return bytes;
+}
+
+size_t Vocabulary::nodeSize() {
+    return sizeof(Node);
+}
+
+VocabularyBackend Vocabulary::backend() const {
+    return backend_;
+}
+
+void Vocabulary::clear(){
+    nodes_.clear();
+    root_ = NIL;
+    freeList_ = NIL;
+    size_ = 0;
+    markIndexStale();
+    cacheReset();
+}
+
+namespace {
+
+const size_t CACHE_WAYS = 4;
+
+}
+
+void Vocabulary::setCacheCapacity(size_t entries){
+    size_t sets = 0;
+    if(entries > 0){
+        sets = 1;
+        while(sets * CACHE_WAYS < entries) sets *= 2;
+    }
+    cache_.assign(sets * CACHE_WAYS, CacheSlot{0, NIL, 0});
+    cacheHands_.assign(sets, 0);
+}
+
+size_t Vocabulary::cacheCapacity() const{
+    return cache_.size();
+}
+
+Vocabulary::CacheStats Vocabulary::cacheStats() const{
+    return CacheStats{cacheHits_, cacheMisses_, cacheEvictions_};
+}
+
+void Vocabulary::resetCacheStats(){
+    cacheHits_ = 0;
+    cacheMisses_ = 0;
+    cacheEvictions_ = 0;
+}
+
+void Vocabulary::cacheReset(){
+    fill(cache_.begin(), cache_.end(), CacheSlot{0, NIL, 0});
+    fill(cacheHands_.begin(), cacheHands_.end(), 0);
+}
+
+// Свободный канал набора или первый канал под стрелкой без бита обращения;
+// встреченные по пути биты сбрасываются (второй шанс)
+void Vocabulary::cacheInsert(size_t hash, uint32_t node) const{
+    size_t set = hash & (cacheHands_.size() - 1);
+    CacheSlot* ways = &cache_[set * CACHE_WAYS];
+    for(size_t way = 0; way < CACHE_WAYS; ++way){
+        if(ways[way].node == NIL){
+            ways[way] = CacheSlot{hash, node, 1};
+            return;
+        }
+    }
+    uint8_t& hand = cacheHands_[set];
+    while(ways[hand].referenced){
+        ways[hand].referenced = 0;
+        hand = (hand + 1) % CACHE_WAYS;
+    }
+    ways[hand] = CacheSlot{hash, node, 1};
+    hand = (hand + 1) % CACHE_WAYS;
+    ++cacheEvictions_;
+}
+
+void Vocabulary::cacheForget(uint32_t node){
+    if(cache_.empty()) return;
+    size_t hash = std::hash<string_view>()(nodes_[node].english);
+    CacheSlot* ways = &cache_[(hash & (cacheHands_.size() - 1)) * CACHE_WAYS];
+    for(size_t way = 0; way < CACHE_WAYS; ++way){
+        if(ways[way].node == node) ways[way] = CacheSlot{0, NIL, 0};
+    }
+}
+
+void Vocabulary::markIndexStale(){
+    indexStale_ = true;
+    staleLookups_ = 0;
+}
+
+namespace {
+
+// Первые 8 байт ключа как число с порядком байтов big-endian: сравнение чисел
+// совпадает с лексикографическим сравнением этих байтов
+uint64_t keyPrefix(string_view key){
+    uint64_t prefix = 0;
+    for(size_t i = 0; i < 8; ++i){
+        prefix = (prefix << 8) | (i < key.size() ? static_cast<unsigned char>(key[i]) : 0);
+    }
+    return prefix;
+}
+
+}
+
+void Vocabulary::fillIndex(size_t position, const vector<uint32_t>& sorted, size_t& next) const{
+    if(position >= index_.size()) return;
+    fillIndex(2 * position, sorted, next);
+    const string& english = nodes_[sorted[next]].english;
+    index_[position] = IndexEntry{keyPrefix(english), sorted[next], static_cast<uint32_t>(english.size())};
+    ++next;
+    fillIndex(2 * position + 1, sorted, next);
+}
+
+void Vocabulary::reindex() const{
+    vector<uint32_t> sorted;
+    sorted.reserve(size());
+    for(const_iterator it = begin(); it != end(); ++it) sorted.push_back(it.index_);
+    // Позиция 0 не используется: дети позиции k лежат в 2k и 2k + 1
+    index_.assign(sorted.size() + 1, IndexEntry{0, NIL, 0});
+    size_t next = 0;
+    fillIndex(1, sorted, next);
+    indexStale_ = false;
+    staleLookups_ = 0;
+}
+
+uint32_t Vocabulary::findInIndex(string_view english) const{
+    const uint64_t prefix = keyPrefix(english);
+    const size_t count = index_.size() - 1;
+    const IndexEntry* entries = index_.data();
+    auto compare = [this, prefix, english](const IndexEntry& entry) {
+        if(entry.prefix != prefix) return entry.prefix < prefix ? -1 : 1;
+        if(entry.length <= 8 && english.size() <= 8) {
+            return entry.length < english.size() ? -1 : (entry.length > english.size() ? 1 : 0);
+        }
+        return nodes_[entry.node].english.compare(english);
+    };
+    size_t position = 1;
+    while(position <= count){
+        // Четыре 16-байтовых записи правнуков лежат в одной строке кэша
+        __builtin_prefetch(entries + 4 * position);
+        position = 2 * position + (compare(entries[position]) < 0);
+    }
+    // Отбрасываем шаги вправо, сделанные после последнего шага влево
+    position >>= __builtin_ffsll(~static_cast<long long>(position));
+    if(position == 0 || compare(entries[position]) != 0) return NIL;
+    return entries[position].node;
+}
+
+// Пакетная загрузка: одна сортировка и линейная сборка идеально сбалансированного
+// дерева. При повторах ключа остается первая пара, как и при поочередном +=.
+void Vocabulary::assign(vector<pair<string, string>> pairs){
+    clear();
+    stable_sort(pairs.begin(), pairs.end(),
+        [](const pair<string, string>& a, const pair<string, string>& b) { return a.first < b.first; });
+    pairs.erase(unique(pairs.begin(), pairs.end(),
+        [](const pair<string, string>& a, const pair<string, string>& b) { return a.first == b.first; }),
+        pairs.end());
+
+    nodes_.reserve(pairs.size());
+    for (auto& words : pairs) {
+        nodes_.push_back(Node{{std::move(words.first), std::move(words.second)}, NIL, NIL, NIL, 1});
+    }
+    size_ = nodes_.size();
+    setRoot(linkBalanced(0, static_cast<uint32_t>(nodes_.size())));
+    if (backend_ == VocabularyBackend::Eytzinger) reindex();
+}
+
+vector<uint32_t> Vocabulary::inOrder() const{
+    vector<uint32_t> order;
+    order.reserve(size_);
+    visitInOrder([this, &order](const Node& node) {
+        order.push_back(static_cast<uint32_t>(&node - nodes_.data()));
+    });
+    return order;
+}
+
+// Обе последовательности режутся по одним и тем же ключам-разделителям, взятым
+// из большей из них, поэтому части не пересекаются. Сначала каждая часть считает
+// свой размер, затем пишет узлы в общий массив со своего смещения.
+void Vocabulary::merge(const Vocabulary& other, ConflictPolicy policy, size_t threads){
+    if(&other == this || other.empty()) return;
+    vector<uint32_t> mine = inOrder();
+    vector<uint32_t> theirs = other.inOrder();
+    const vector<Node>& otherNodes = other.nodes_;
+
+    const size_t minimumPart = 1 << 15;
+    size_t total = mine.size() + theirs.size();
+    size_t parts = min(threads ? threads : 1, (total + minimumPart - 1) / minimumPart);
+    if(parts == 0) parts = 1;
+
+    vector<size_t> mineBounds(parts + 1, mine.size());
+    vector<size_t> theirsBounds(parts + 1, theirs.size());
+    mineBounds[0] = 0;
+    theirsBounds[0] = 0;
+    bool splitMine = mine.size() >= theirs.size();
+    for(size_t part = 1; part < parts; ++part){
+        if(splitMine){
+            mineBounds[part] = mine.size() * part / parts;
+            const string& key = nodes_[mine[mineBounds[part]]].english;
+            theirsBounds[part] = std::lower_bound(theirs.begin(), theirs.end(), key,
+                [&otherNodes](uint32_t index, const string& value) { return otherNodes[index].english < value; }) - theirs.begin();
+        } else {
+            theirsBounds[part] = theirs.size() * part / parts;
+            const string& key = otherNodes[theirs[theirsBounds[part]]].english;
+            mineBounds[part] = std::lower_bound(mine.begin(), mine.end(), key,
+                [this](uint32_t index, const string& value) { return nodes_[index].english < value; }) - mine.begin();
+        }
+    }
+
+    vector<Node> merged;
+    vector<size_t> counts(parts, 0);
+    vector<size_t> offsets(parts, 0);
+    // Первый проход только считает размер части, второй пишет узлы:
+    // свои строки переносятся, строки другого словаря копируются
+    auto mergePart = [&](size_t part, bool write) {
+        size_t i = mineBounds[part], iEnd = mineBounds[part + 1];
+        size_t j = theirsBounds[part], jEnd = theirsBounds[part + 1];
+        size_t out = offsets[part];
+        while(i < iEnd || j < jEnd){
+            int compared = i == iEnd ? 1 : j == jEnd ? -1
+                : nodes_[mine[i]].english.compare(otherNodes[theirs[j]].english);
+            if(write){
+                Node& target = merged[out];
+                if(compared <= 0){
+                    Node& source = nodes_[mine[i]];
+                    target.english = std::move(source.english);
+                    target.russian = compared == 0 && policy == ConflictPolicy::Overwrite
+                        ? otherNodes[theirs[j]].russian : std::move(source.russian);
+                } else {
+                    target.english = otherNodes[theirs[j]].english;
+                    target.russian = otherNodes[theirs[j]].russian;
+                }
+            }
+            if(compared <= 0) ++i;
+            if(compared >= 0) ++j;
+            ++out;
+        }
+        if(!write) counts[part] = out;
+    };
+    auto runParts = [&](bool write) {
+        if(parts == 1){
+            mergePart(0, write);
+            return;
+        }
+        vector<thread> pool;
+        for(size_t part = 0; part < parts; ++part){
+            pool.emplace_back([&mergePart, part, write]() { mergePart(part, write); });
+        }
+        for(thread& worker : pool) worker.join();
+    };
+
+    runParts(false);
+    for(size_t part = 1; part < parts; ++part) offsets[part] = offsets[part - 1] + counts[part - 1];
+    merged.resize(offsets[parts - 1] + counts[parts - 1]);
+    runParts(true);
+
+    for(Node& node : merged){
+        node.left = NIL;
+        node.right = NIL;
+        node.parent = NIL;
+        node.height = 1;
+    }
+    clear();
+    nodes_ = std::move(merged);
+    size_ = nodes_.size();
+    setRoot(linkBalanced(0, static_cast<uint32_t>(nodes_.size())));
+    if(backend_ == VocabularyBackend::Eytzinger) reindex();
+}
+
+uint32_t Vocabulary::linkBalanced(uint32_t first, uint32_t last){
+    if(first >= last) return NIL;
+    uint32_t middle = first + (last - first) / 2;
+    uint32_t left = linkBalanced(first, middle);
+    uint32_t right = linkBalanced(middle + 1, last);
+    linkLeft(middle, left);
+    linkRight(middle, right);
+    updateHeight(middle);
+    return middle;
+}
+
+uint32_t Vocabulary::allocateNode(const string& english, const string& russian){
+    ++size_;
+    markIndexStale();
+    if(freeList_ != NIL){
+        uint32_t index = freeList_;
+        Node& node = nodes_[index];
+        freeList_ = node.left;
+        node.english = english;
+        node.russian = russian;
+        node.left = NIL;
+        node.right = NIL;
+        node.parent = NIL;
+        node.height = 1;
+        return index;
+    }
+    nodes_.push_back(Node{{english, russian}, NIL, NIL, NIL, 1});
+    return static_cast<uint32_t>(nodes_.size() - 1);
+}
+
+void Vocabulary::releaseNode(uint32_t index){
+    cacheForget(index);
+    --size_;
+    markIndexStale();
+    Node& node = nodes_[index];
+    node.english.clear();
+    node.russian.clear();
+    node.right = NIL;
+    node.left = freeList_;
+    freeList_ = index;
+}
+
+void Vocabulary::setRoot(uint32_t index){
+    root_ = index;
+    if(index != NIL) nodes_[index].parent = NIL;
+}
+
+void Vocabulary::linkLeft(uint32_t index, uint32_t child){
+    nodes_[index].left = child;
+    if(child != NIL) nodes_[child].parent = index;
+}
+
+void Vocabulary::linkRight(uint32_t index, uint32_t child){
+    nodes_[index].right = child;
+    if(child != NIL) nodes_[child].parent = index;
+}
+
+uint32_t Vocabulary::leftmost(uint32_t index) const{
+    if(index == NIL) return NIL;
+    while(nodes_[index].left != NIL) index = nodes_[index].left;
+    return index;
+}
+
+uint32_t Vocabulary::rightmost(uint32_t index) const{
+    if(index == NIL) return NIL;
+    while(nodes_[index].right != NIL) index = nodes_[index].right;
+    return index;
+}
+
+uint32_t Vocabulary::successor(uint32_t index) const{
+    if(nodes_[index].right != NIL) return leftmost(nodes_[index].right);
+    uint32_t parent = nodes_[index].parent;
+    while(parent != NIL && nodes_[parent].right == index){
+        index = parent;
+        parent = nodes_[parent].parent;
+    }
+    return parent;
+}
+
+// Шаг назад от end() ведет к наибольшему слову
+uint32_t Vocabulary::predecessor(uint32_t index) const{
+    if(index == NIL) return rightmost(root_);
+    if(nodes_[index].left != NIL) return rightmost(nodes_[index].left);
+    uint32_t parent = nodes_[index].parent;
+    while(parent != NIL && nodes_[parent].left == index){
+        index = parent;
+        parent = nodes_[parent].parent;
+    }
+    return parent;
+}
+
+int32_t Vocabulary::heightOf(uint32_t index) const{
+    return index == NIL ? 0 : nodes_[index].height;
+}
+
+void Vocabulary::updateHeight(uint32_t index){
+    Node& node = nodes_[index];
+    int32_t leftHeight = heightOf(node.left);
+    int32_t rightHeight = heightOf(node.right);
+    node.height = 1 + (leftHeight > rightHeight ? leftHeight : rightHeight);
+}
+
+uint32_t Vocabulary::rotateLeft(uint32_t index){
+    uint32_t newRoot = nodes_[index].right;
+    linkRight(index, nodes_[newRoot].left);
+    linkLeft(newRoot, index);
+    updateHeight(index);
+    updateHeight(newRoot);
+    return newRoot;
+}
+
+uint32_t Vocabulary::rotateRight(uint32_t index){
+    uint32_t newRoot = nodes_[index].left;
+    linkLeft(index, nodes_[newRoot].right);
+    linkRight(newRoot, index);
+    updateHeight(index);
+    updateHeight(newRoot);
+    return newRoot;
+}
+
+uint32_t Vocabulary::rebalance(uint32_t index){
+    updateHeight(index);
+    uint32_t left = nodes_[index].left;
+    uint32_t right = nodes_[index].right;
+    int32_t balance = heightOf(left) - heightOf(right);
+    if(balance > 1){
+        if(heightOf(nodes_[left].left) < heightOf(nodes_[left].right)) linkLeft(index, rotateLeft(left));
+        return rotateRight(index);
+    }
+    if(balance < -1){
+        if(heightOf(nodes_[right].right) < heightOf(nodes_[right].left)) linkRight(index, rotateRight(right));
+        return rotateLeft(index);
+    }
+    return index;
+}
+
+uint32_t Vocabulary::insertNode(uint32_t index, const string& english, const string& russian){
+    if(index == NIL) return allocateNode(english, russian);
+    if(english < nodes_[index].english){
+        uint32_t left = insertNode(nodes_[index].left, english, russian);
+        linkLeft(index, left);
+    } else if(english > nodes_[index].english){
+        uint32_t right = insertNode(nodes_[index].right, english, russian);
+        linkRight(index, right);
+    } else {
+        return index;
+    }
+    return rebalance(index);
+}
+
+uint32_t Vocabulary::removeNode(uint32_t index, const string& english){
+    if(index == NIL) return NIL;
+    Node& node = nodes_[index];
+    if(english < node.english){
+        linkLeft(index, removeNode(node.left, english));
+    } else if(english > node.english){
+        linkRight(index, removeNode(node.right, english));
+    } else {
+        if(node.left == NIL || node.right == NIL){
+            uint32_t child = node.left != NIL ? node.left : node.right;
+            releaseNode(index);
+            return child;
+        }
+        uint32_t minIndex = node.right;
+        while(nodes_[minIndex].left != NIL) minIndex = nodes_[minIndex].left;
+        // Удаляемая пара переезжает в самый левый узел правого поддерева
+        cacheForget(minIndex);
+        node.english.swap(nodes_[minIndex].english);
+        node.russian.swap(nodes_[minIndex].russian);
+        linkRight(index, removeNode(node.right, nodes_[minIndex].english));
+    }
+    return rebalance(index);
+}
+
+// Пока индекс устарел, поиск идет по дереву; индекс перестраивается, когда
+// таких поисков набирается достаточно, чтобы окупить O(n) перестройки
+// Перевод меняется на месте, а узлы не переезжают при вставке, поэтому запись
+// кэша устаревает только при удалении слова — это делают releaseNode и removeNode
+uint32_t Vocabulary::findIndex(string_view english) const{
+    if(cache_.empty()) return findUncached(english);
+    size_t hash = std::hash<string_view>()(english);
+    CacheSlot* ways = &cache_[(hash & (cacheHands_.size() - 1)) * CACHE_WAYS];
+    for(size_t way = 0; way < CACHE_WAYS; ++way){
+        if(ways[way].node != NIL && ways[way].hash == hash && nodes_[ways[way].node].english == english){
+            ways[way].referenced = 1;
+            ++cacheHits_;
+            return ways[way].node;
+        }
+    }
+    ++cacheMisses_;
+    uint32_t index = findUncached(english);
+    if(index != NIL) cacheInsert(hash, index);
+    return index;
+}
+
+uint32_t Vocabulary::findUncached(string_view english) const{
+    if(backend_ == VocabularyBackend::Eytzinger){
+        if(!indexStale_) return findInIndex(english);
+        if(++staleLookups_ > 64 + size_ / 16){
+            reindex();
+            return findInIndex(english);
+        }
+    }
+    uint32_t current = root_;
+    while(current != NIL){
+        const Node& node = nodes_[current];
+        int compared = english.compare(node.english);
+        if(compared == 0) return current;
+        current = compared < 0 ? node.left : node.right;
+    }
+    return NIL;
 }
 
 Vocabulary& Vocabulary::operator+=(const pair<string, string>& pairWords){
-    if(!getRoot()) setRoot(new Tree(pairWords.first, pairWords.second));
-    else getRoot()->addNodeTree(pairWords.first, pairWords.second);
+    setRoot(insertNode(root_, pairWords.first, pairWords.second));
     return *this;
 }
 
-Vocabulary& Vocabulary::operator-=(const string& english){ 
-    if(getRoot()) setRoot(getRoot()->deleteNodeTree(english));
+Vocabulary& Vocabulary::operator-=(const string& english){
+    setRoot(removeNode(root_, english));
     return *this;
 }
 
-string Vocabulary::operator[](const string& english) const{
-    if(getRoot()) {
-        Tree* foundNode=getRoot()->findNode(english);
-        if(foundNode) return foundNode->getRussian();
+const string* Vocabulary::find(string_view english) const{
+    uint32_t index = findIndex(english);
+    return index != NIL ? &nodes_[index].russian : nullptr;
+}
+
+string* Vocabulary::find(string_view english){
+    uint32_t index = findIndex(english);
+    return index != NIL ? &nodes_[index].russian : nullptr;
+}
+
+bool Vocabulary::contains(string_view english) const{
+    return findIndex(english) != NIL;
+}
+
+// Ключи отсортированы и различны: часть меньше узла уходит влево, больше — вправо,
+// так что каждый узел посещается не более одного раза за весь пакет
+void Vocabulary::findSorted(uint32_t index, const string_view* keys, size_t count, uint32_t* found) const{
+    if(count == 0) return;
+    if(index == NIL){
+        fill(found, found + count, NIL);
+        return;
+    }
+    const Node& node = nodes_[index];
+    const string_view* split = std::lower_bound(keys, keys + count, string_view(node.english));
+    size_t less = split - keys;
+    findSorted(node.left, keys, less, found);
+    size_t equal = (less < count && keys[less] == node.english) ? 1 : 0;
+    if(equal) found[less] = index;
+    findSorted(node.right, split + equal, count - less - equal, found + less + equal);
+}
+
+// Повторы отсекаются открытой адресацией; ключи сравниваются только при совпадении хеша
+void Vocabulary::translateChunk(const string_view* tokens, size_t count, const string** translations) const{
+    struct Slot{
+        size_t hash;
+        uint32_t id;
+    };
+    size_t capacity = 1024;
+    vector<Slot> slots(capacity, Slot{0, NIL});
+    vector<string_view> distinct;
+    vector<uint32_t> tokenIds(count);
+    hash<string_view> hasher;
+    for(size_t i = 0; i < count; ++i){
+        if(distinct.size() * 2 >= capacity){
+            capacity *= 2;
+            vector<Slot> grown(capacity, Slot{0, NIL});
+            for(const Slot& slot : slots){
+                if(slot.id == NIL) continue;
+                size_t position = slot.hash & (capacity - 1);
+                while(grown[position].id != NIL) position = (position + 1) & (capacity - 1);
+                grown[position] = slot;
+            }
+            slots.swap(grown);
+        }
+        size_t tokenHash = hasher(tokens[i]);
+        size_t position = tokenHash & (capacity - 1);
+        while(slots[position].id != NIL &&
+              (slots[position].hash != tokenHash || distinct[slots[position].id] != tokens[i])){
+            position = (position + 1) & (capacity - 1);
+        }
+        if(slots[position].id == NIL){
+            slots[position] = Slot{tokenHash, static_cast<uint32_t>(distinct.size())};
+            distinct.push_back(tokens[i]);
+        }
+        tokenIds[i] = slots[position].id;
+    }
+
+    vector<uint32_t> order(distinct.size());
+    iota(order.begin(), order.end(), 0);
+    sort(order.begin(), order.end(), [&distinct](uint32_t a, uint32_t b) { return distinct[a] < distinct[b]; });
+    vector<string_view> sortedKeys(distinct.size());
+    for(size_t i = 0; i < order.size(); ++i) sortedKeys[i] = distinct[order[i]];
+
+    vector<uint32_t> found(sortedKeys.size());
+    findSorted(root_, sortedKeys.data(), sortedKeys.size(), found.data());
+    vector<const string*> byId(distinct.size());
+    for(size_t i = 0; i < order.size(); ++i){
+        byId[order[i]] = found[i] != NIL ? &nodes_[found[i]].russian : nullptr;
+    }
+    for(size_t i = 0; i < count; ++i){
+        translations[i] = byId[tokenIds[i]];
+    }
+}
+
+void Vocabulary::translate(const string_view* tokens, size_t count, const string** translations, size_t threads) const{
+    const size_t minimumChunk = 1 << 16;
+    size_t workers = min(threads ? threads : 1, (count + minimumChunk - 1) / minimumChunk);
+    if(workers <= 1){
+        translateChunk(tokens, count, translations);
+        return;
+    }
+    vector<thread> pool;
+    size_t chunk = (count + workers - 1) / workers;
+    for(size_t first = 0; first < count; first += chunk){
+        size_t length = min(chunk, count - first);
+        pool.emplace_back([this, tokens, translations, first, length]() {
+            translateChunk(tokens + first, length, translations + first);
+        });
+    }
+    for(thread& worker : pool) worker.join();
+}
+
+vector<const string*> Vocabulary::translate(const vector<string_view>& tokens, size_t threads) const{
+    vector<const string*> translations(tokens.size());
+    translate(tokens.data(), tokens.size(), translations.data(), threads);
+    return translations;
+}
+
+const string& Vocabulary::operator[](string_view english) const{
+    static const string missing;
+    uint32_t index = findIndex(english);
+    return index != NIL ? nodes_[index].russian : missing;
+}
+
+string& Vocabulary::operator[](string_view english) {
+    uint32_t index = findIndex(english);
+    if(index == NIL) {
+        *this += {string(english), ""};
+        index = findIndex(english);
+    }
+    return nodes_[index].russian;
+}
+
+Vocabulary::const_iterator Vocabulary::begin() const{
+    return const_iterator(this, leftmost(root_));
+}
+
+Vocabulary::const_iterator Vocabulary::end() const{
+    return const_iterator(this, NIL);
+}
+
+Vocabulary::const_iterator Vocabulary::lower_bound(string_view english) const{
+    uint32_t current = root_;
+    uint32_t candidate = NIL;
+    while(current != NIL){
+        if(english.compare(nodes_[current].english) <= 0){
+            candidate = current;
+            current = nodes_[current].left;
+        } else {
+            current = nodes_[current].right;
+        }
+    }
+    return const_iterator(this, candidate);
+}
+
+Vocabulary::const_iterator Vocabulary::upper_bound(string_view english) const{
+    uint32_t current = root_;
+    uint32_t candidate = NIL;
+    while(current != NIL){
+        if(english.compare(nodes_[current].english) < 0){
+            candidate = current;
+            current = nodes_[current].left;
+        } else {
+            current = nodes_[current].right;
+        }
+    }
+    return const_iterator(this, candidate);
+}
+
+pair<Vocabulary::const_iterator, Vocabulary::const_iterator> Vocabulary::equal_range(string_view english) const{
+    const_iterator first = lower_bound(english);
+    if(first != end() && english == first->english){
+        const_iterator last = first;
+        return make_pair(first, ++last);
     }
-    return "";
+    return make_pair(first, first);
 }
 
-string& Vocabulary::operator[](const string& english) {
-   Tree* foundNode = getRoot() ? getRoot()->findNode(english) : nullptr;
-   if(!foundNode) {
-        *this += {english, ""};
-        foundNode = getRoot()->findNode(english);
-   }
-   string russian = foundNode->getRussian();
-   string* word =&russian;
-   return *word;
+// Слова с общим началом идут подряд: ищем первое слово не меньше начала
+// и первое слово больше него, которое уже не начинается с него
+Vocabulary::Range Vocabulary::prefix(string_view start) const{
+    uint32_t current = root_;
+    uint32_t candidate = NIL;
+    while(current != NIL){
+        string_view english = nodes_[current].english;
+        bool beyond = english.compare(start) > 0 && english.substr(0, start.size()) != start;
+        if(beyond){
+            candidate = current;
+            current = nodes_[current].left;
+        } else {
+            current = nodes_[current].right;
+        }
+    }
+    return Range(lower_bound(start), const_iterator(this, candidate));
 }
 
 bool Vocabulary::operator==(const Vocabulary& other) const{
-    if (getRoot() == nullptr && other.getRoot() == nullptr) return true;
-    if (getRoot() == nullptr || other.getRoot() == nullptr) return false;
-    return *getRoot() == *other.getRoot();  
+    if (size() != other.size()) return false;
+    vector<const Node*> entries;
+    entries.reserve(size());
+    visitInOrder([&entries](const Node& node) { entries.push_back(&node); });
+    size_t position = 0;
+    bool equal = true;
+    other.visitInOrder([&](const Node& node) {
+        if (equal && (entries[position]->english != node.english || entries[position]->russian != node.russian)) {
+            equal = false;
+        }
+        ++position;
+    });
+    return equal;
 }
 
 bool Vocabulary::operator!=(const Vocabulary& other) const{
@@ -71,44 +739,245 @@ ostream& operator<<(ostream& out, const Vocabulary& vocabulary) {
     return out;
 }
 
+// Пустой словарь или сравнимый с ним ввод — пакетная перестройка через assign.
+// Небольшой ввод в большой словарь вставляется по одному слову, чтобы не
+// копировать и не пересортировывать уже имеющиеся n пар
 istream& operator>>(istream& in, Vocabulary& vocabulary) {
+    vector<pair<string, string>> pairs;
     string english, russian;
     while (in >> english >> russian) {
-        vocabulary += make_pair(english, russian);
+        pairs.emplace_back(std::move(english), std::move(russian));
+    }
+    if (pairs.size() < vocabulary.size()) {
+        // При повторах во вводе остается первый перевод, как и в assign
+        stable_sort(pairs.begin(), pairs.end(),
+            [](const pair<string, string>& a, const pair<string, string>& b) { return a.first < b.first; });
+        pairs.erase(unique(pairs.begin(), pairs.end(),
+            [](const pair<string, string>& a, const pair<string, string>& b) { return a.first == b.first; }),
+            pairs.end());
+        for (const pair<string, string>& words : pairs) {
+            vocabulary += words;
+        }
+        return in;
     }
+    // Уже имеющиеся слова идут первыми, чтобы при повторах сохранить их перевод
+    vector<pair<string, string>> all;
+    all.reserve(vocabulary.size() + pairs.size());
+    vocabulary.visitInOrder([&all](const Vocabulary::Node& node) {
+        all.emplace_back(node.english, node.russian);
+    });
+    move(pairs.begin(), pairs.end(), back_inserter(all));
+    vocabulary.assign(std::move(all));
     return in;
 }
 
 void Vocabulary::printVocabulary(ostream& out) const{
     out << "Англо-русский словарь:\n";
-    if (getRoot()) {
-        getRoot()->printTree(out);
+    if (!empty()) {
+        visitInOrder([&out](const Node& node) {
+            out << node.english << " - " << node.russian << "\n";
+        });
     } else {
         out << "Словарь пуст\n";
     }
 }
 
+// Двоичный файл копируется целиком, поэтому смещения каждой записи проверяются
+// здесь: испорченный файл не загружается, а словарь остается прежним
 bool Vocabulary::loadFromFile(const string& filename) {
-    ifstream file(filename);
+    if (MappedVocabulary::isBinaryFile(filename)) {
+        MappedVocabulary mapped;
+        if (!mapped.open(filename)) {
+            return false;
+        }
+        vector<pair<string, string>> pairs;
+        pairs.reserve(mapped.size());
+        for (size_t i = 0; i < mapped.size(); ++i) {
+            if (!mapped.entryValid(i)) {
+                return false;
+            }
+            pairs.emplace_back(string(mapped.englishAt(i)), string(mapped.russianAt(i)));
+        }
+        assign(std::move(pairs));
+        return true;
+    }
+    return loadFromTextFile(filename);
+}
+
+namespace {
+
+bool isSpace(char symbol) {
+    return symbol == ' ' || symbol == '\n' || symbol == '\t' || symbol == '\r' || symbol == '\v' || symbol == '\f';
+}
+
+// Первая строка файла с контрольными суммами. В обычном файле в строке два
+// слова, поэтому строка из трех слов с ним не совпадает
+const string_view CHECKSUM_HEADER = "#vocabulary checksums crc32\n";
+const string_view CRC_DIRECTIVE = "#crc32 ";
+const string_view END_DIRECTIVE = "#end ";
+
+}
+
+// Файл читается целиком; слова по-прежнему идут парами независимо от строк.
+// Директивы контрольных сумм ищутся только после заголовка CHECKSUM_HEADER,
+// так что в обычном файле слова "#crc32" и "#end" — просто слова. "#crc32"
+// считается директивой, только если за ним через пробелы два числа (в строке
+// пары слов пробел один), а "#end" — только в последней строке файла
+bool Vocabulary::loadFromTextFile(const string& filename) {
+    ifstream file(filename, ios::binary);
     if (!file.is_open()) {
         return false;
     }
-    
-    delete getRoot();
-    setRoot(nullptr);
-    
-    string english, russian;
-    while (file >> english >> russian) {
-        operator+=(make_pair(english, russian));
-    }
-    
+    string content;
+    file.seekg(0, ios::end);
+    content.resize(static_cast<size_t>(file.tellg()));
+    file.seekg(0, ios::beg);
+    file.read(&content[0], content.size());
     file.close();
+
+    vector<string_view> words;
+    bool checksummed = content.compare(0, CHECKSUM_HEADER.size(), CHECKSUM_HEADER) == 0;
+    bool ended = false;
+    bool valid = true;
+    uint32_t chunkCrc = 0;
+    size_t chunkBytes = 0;
+    size_t position = checksummed ? CHECKSUM_HEADER.size() : 0;
+    while (position < content.size() && valid) {
+        size_t lineEnd = content.find('\n', position);
+        lineEnd = lineEnd == string::npos ? content.size() : lineEnd + 1;
+        string_view line(content.data() + position, lineEnd - position);
+        position = lineEnd;
+
+        if (checksummed && line.substr(0, CRC_DIRECTIVE.size()) == CRC_DIRECTIVE) {
+            unsigned long long bytes = 0;
+            unsigned crc = 0;
+            int parsed = 0;
+            if (count(line.begin(), line.end(), ' ') == 2 &&
+                sscanf(string(line).c_str(), "#crc32 %llu %x %n", &bytes, &crc, &parsed) == 2 &&
+                static_cast<size_t>(parsed) == line.size()) {
+                valid = !ended && bytes == chunkBytes && crc == chunkCrc;
+                chunkCrc = 0;
+                chunkBytes = 0;
+                continue;
+            }
+        }
+        if (checksummed && position == content.size() && line.substr(0, END_DIRECTIVE.size()) == END_DIRECTIVE) {
+            unsigned long long count = 0;
+            valid = chunkBytes == 0 && sscanf(string(line).c_str(), "#end %llu", &count) == 1 &&
+                    count * 2 == words.size();
+            ended = true;
+            continue;
+        }
+        valid = !ended;
+        chunkCrc = crc32(line.data(), line.size(), chunkCrc);
+        chunkBytes += line.size();
+        size_t start = 0;
+        while (start < line.size()) {
+            while (start < line.size() && isSpace(line[start])) ++start;
+            size_t end = start;
+            while (end < line.size() && !isSpace(line[end])) ++end;
+            if (end > start) words.push_back(line.substr(start, end - start));
+            start = end;
+        }
+    }
+    if (!valid || (checksummed && !ended)) {
+        return false;
+    }
+
+    vector<pair<string, string>> pairs;
+    pairs.reserve(words.size() / 2);
+    for (size_t i = 0; i + 1 < words.size(); i += 2) {
+        pairs.emplace_back(string(words[i]), string(words[i + 1]));
+    }
+    assign(std::move(pairs));
     return true;
 }
 
-bool Vocabulary::saveToFile(const string& filename) const {
-    if (!getRoot()) {
+bool Vocabulary::saveToFile(const string& filename, VocabularyFormat format) const {
+    SaveOptions options;
+    options.format = format;
+    return saveToFile(filename, options);
+}
+
+bool Vocabulary::saveToFile(const string& filename, const SaveOptions& options) const {
+    if (empty()) {
+        return false;
+    }
+    if (options.format == VocabularyFormat::Binary) {
+        return saveToBinaryFile(filename, options);
+    }
+    return saveToTextFile(filename, options);
+}
+
+bool Vocabulary::saveToTextFile(const string& filename, const SaveOptions& options) const {
+    BufferedWriter writer(options.bufferSize);
+    if (!writer.open(filename, options.atomic)) {
+        return false;
+    }
+    uint32_t chunkCrc = 0;
+    size_t chunkBytes = 0;
+    char directive[64];
+    if (options.checksums) {
+        writer.write(CHECKSUM_HEADER);
+    }
+    auto writeChecksum = [&]() {
+        int length = snprintf(directive, sizeof(directive), "#crc32 %zu %08x\n", chunkBytes, chunkCrc);
+        writer.write(directive, length);
+        chunkCrc = 0;
+        chunkBytes = 0;
+    };
+    visitInOrder([&](const Node& node) {
+        writer.write(node.english);
+        writer.put(' ');
+        writer.write(node.russian);
+        writer.put('\n');
+        if (options.checksums) {
+            chunkCrc = crc32(node.english.data(), node.english.size(), chunkCrc);
+            chunkCrc = crc32(" ", 1, chunkCrc);
+            chunkCrc = crc32(node.russian.data(), node.russian.size(), chunkCrc);
+            chunkCrc = crc32("\n", 1, chunkCrc);
+            chunkBytes += node.english.size() + node.russian.size() + 2;
+            if (chunkBytes >= options.checksumChunk) writeChecksum();
+        }
+    });
+    if (options.checksums) {
+        if (chunkBytes > 0) writeChecksum();
+        int length = snprintf(directive, sizeof(directive), "#end %zu\n", size());
+        writer.write(directive, length);
+    }
+    return writer.commit();
+}
+
+bool Vocabulary::saveToBinaryFile(const string& filename, const SaveOptions& options) const {
+    vector<VocabularyFileEntry> entries;
+    entries.reserve(size());
+    uint64_t offset = 0;
+    visitInOrder([&entries, &offset](const Node& node) {
+        VocabularyFileEntry entry;
+        entry.englishOffset = static_cast<uint32_t>(offset);
+        entry.englishLength = static_cast<uint32_t>(node.english.size());
+        entry.russianOffset = static_cast<uint32_t>(offset + node.english.size());
+        entry.russianLength = static_cast<uint32_t>(node.russian.size());
+        offset += node.english.size() + node.russian.size();
+        entries.push_back(entry);
+    });
+    if (offset > UINT32_MAX) {
+        return false;
+    }
+
+    BufferedWriter writer(options.bufferSize);
+    if (!writer.open(filename, options.atomic)) {
         return false;
     }
-    return getRoot()->saveToFile(filename);
+    VocabularyFileHeader header;
+    memcpy(header.magic, VOCABULARY_FILE_MAGIC, sizeof(header.magic));
+    header.version = VOCABULARY_FILE_VERSION;
+    header.count = entries.size();
+    writer.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    writer.write(reinterpret_cast<const char*>(entries.data()), entries.size() * sizeof(VocabularyFileEntry));
+    visitInOrder([&writer](const Node& node) {
+        writer.write(node.english);
+        writer.write(node.russian);
+    });
+    return writer.commit();
 }
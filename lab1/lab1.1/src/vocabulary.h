@@ -1,36 +1,234 @@
 #ifndef VOCABULARY_H
 #define VOCABULARY_H
 
-#include "tree.h"
 #include <iostream>
 #include <fstream>
 #include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+#include <iterator>
 
 using namespace std;
 
+enum class VocabularyFormat{ Text, Binary };
+
+// Параметры сохранения. atomic — запись во временный файл и rename;
+// checksums — текстовый файл начинается строкой "#vocabulary checksums crc32",
+// после каждых checksumChunk байт данных пишется "#crc32 <байт> <crc>", а в
+// конце "#end <число слов>"; по ним loadFromFile обнаруживает обрезанный или
+// испорченный файл. Без заголовка строки с '#' — обычные слова.
+struct SaveOptions{
+    VocabularyFormat format = VocabularyFormat::Text;
+    bool atomic = true;
+    bool checksums = false;
+    size_t checksumChunk = 1 << 16;
+    size_t bufferSize = 1 << 20;
+};
+
+// Что делать при слиянии словарей, если слово есть в обоих
+enum class ConflictPolicy{ KeepExisting, Overwrite };
+
+// Tree — поиск спуском по АВЛ-дереву.
+// Eytzinger — дерево остается упорядоченным хранилищем, а точечный поиск идет по
+// массиву в порядке Эйтцингера с 8-байтовыми префиксами ключей и предвыборкой.
+enum class VocabularyBackend{ Tree, Eytzinger };
+
 class Vocabulary{
+    public:
+    // Пара слов, которую видят итераторы; устройство дерева за ней скрыто
+    struct Entry{
+        string english;
+        string russian;
+    };
+    class const_iterator;
+    class Range;
     private:
-    Tree* root_;
+    // Узлы АВЛ-дерева лежат в одном массиве, дети адресуются 32-битными индексами.
+    // Узел занимает 80 байт против 88 байт + заголовок malloc у Tree,
+    // а копирование и освобождение словаря — одна операция над массивом.
+    static const uint32_t NIL = UINT32_MAX;
+    struct Node : Entry{
+        uint32_t left;
+        uint32_t right;
+        uint32_t parent;
+        int32_t height;
+    };
+    struct IndexEntry{
+        uint64_t prefix;
+        uint32_t node;
+        uint32_t length;
+    };
+    vector<Node> nodes_;
+    uint32_t root_;
+    uint32_t freeList_;
+    size_t size_;
+    VocabularyBackend backend_;
+    mutable vector<IndexEntry> index_;
+    mutable bool indexStale_;
+    mutable size_t staleLookups_;
+    struct CacheSlot{
+        size_t hash;
+        uint32_t node;
+        uint32_t referenced;
+    };
+    mutable vector<CacheSlot> cache_;
+    mutable vector<uint8_t> cacheHands_;
+    mutable size_t cacheHits_;
+    mutable size_t cacheMisses_;
+    mutable size_t cacheEvictions_;
+    void markIndexStale();
+    uint32_t findUncached(string_view english) const;
+    void cacheInsert(size_t hash, uint32_t node) const;
+    void cacheForget(uint32_t node);
+    void cacheReset();
+    uint32_t findInIndex(string_view english) const;
+    void fillIndex(size_t position, const vector<uint32_t>& sorted, size_t& next) const;
+    uint32_t allocateNode(const string& english, const string& russian);
+    void releaseNode(uint32_t index);
+    void setRoot(uint32_t index);
+    void linkLeft(uint32_t index, uint32_t child);
+    void linkRight(uint32_t index, uint32_t child);
+    uint32_t leftmost(uint32_t index) const;
+    uint32_t rightmost(uint32_t index) const;
+    uint32_t successor(uint32_t index) const;
+    uint32_t predecessor(uint32_t index) const;
+    int32_t heightOf(uint32_t index) const;
+    void updateHeight(uint32_t index);
+    uint32_t rotateLeft(uint32_t index);
+    uint32_t rotateRight(uint32_t index);
+    uint32_t rebalance(uint32_t index);
+    uint32_t insertNode(uint32_t index, const string& english, const string& russian);
+    uint32_t removeNode(uint32_t index, const string& english);
+    uint32_t findIndex(string_view english) const;
+    uint32_t linkBalanced(uint32_t first, uint32_t last);
+    void findSorted(uint32_t index, const string_view* keys, size_t count, uint32_t* found) const;
+    void translateChunk(const string_view* tokens, size_t count, const string** translations) const;
+    template <typename Visitor>
+    void visitInOrder(Visitor visit) const;
+    vector<uint32_t> inOrder() const;
+    bool saveToTextFile(const string& filename, const SaveOptions& options) const;
+    bool saveToBinaryFile(const string& filename, const SaveOptions& options) const;
+    bool loadFromTextFile(const string& filename);
     public:
     Vocabulary();
-    Vocabulary(const Vocabulary& copiedVocabulary);
-    ~Vocabulary();
-    Tree* getRoot() const;
-    void setRoot(Tree* root);
-    Vocabulary& operator=(const Vocabulary& other);
+    explicit Vocabulary(VocabularyBackend backend);
+    explicit Vocabulary(vector<pair<string, string>> pairs, VocabularyBackend backend = VocabularyBackend::Tree);
+    Vocabulary(const Vocabulary& copiedVocabulary) = default;
+    Vocabulary(Vocabulary&& movedVocabulary) = default;
+    ~Vocabulary() = default;
+    size_t size() const;
+    bool empty() const;
+    int height() const;
+    size_t memoryUsage() const;
+    // Размер узла арены в байтах, без строк
+    static size_t nodeSize();
+    VocabularyBackend backend() const;
+    // Перестраивает индекс Eytzinger сразу. Иначе он перестраивается при поиске,
+    // поэтому перед чтением из нескольких потоков стоит вызвать reindex().
+    void reindex() const;
+    // Кэш частых слов перед деревом: 4-канальные наборы с вытеснением CLOCK.
+    // 0 отключает кэш. Как и индекс Eytzinger, кэш меняется при константном
+    // поиске, поэтому из нескольких потоков с ним читать нельзя.
+    struct CacheStats{
+        size_t hits;
+        size_t misses;
+        size_t evictions;
+    };
+    void setCacheCapacity(size_t entries);
+    size_t cacheCapacity() const;
+    CacheStats cacheStats() const;
+    void resetCacheStats();
+    void clear();
+    void assign(vector<pair<string, string>> pairs);
+    // Слияние двух упорядоченных последовательностей за O(n + m) с перестройкой
+    // сбалансированного дерева. При threads > 1 пространство ключей делится
+    // на части, которые сливаются параллельно; результат от threads не зависит.
+    void merge(const Vocabulary& other, ConflictPolicy policy = ConflictPolicy::KeepExisting, size_t threads = 1);
+    Vocabulary& operator=(const Vocabulary& other) = default;
+    Vocabulary& operator=(Vocabulary&& other) = default;
     Vocabulary& operator+=(const pair<string, string>& pairWords);
     Vocabulary& operator-=(const string& english);
-    string operator[](const string& english) const;
-    string& operator[](const string& english);
+    // Поиск без выделения памяти. Указатели и ссылки на перевод остаются
+    // действительными до следующего добавления слова в словарь.
+    const string* find(string_view english) const;
+    string* find(string_view english);
+    bool contains(string_view english) const;
+    // Пакетный перевод: повторяющиеся токены ищутся один раз, различные
+    // ключи — одним совместным спуском по дереву. Для слов без перевода — nullptr.
+    void translate(const string_view* tokens, size_t count, const string** translations, size_t threads = 1) const;
+    vector<const string*> translate(const vector<string_view>& tokens, size_t threads = 1) const;
+    const string& operator[](string_view english) const;
+    string& operator[](string_view english);
+    // Обход по возрастанию без рекурсии; итераторы становятся
+    // недействительными после += и -=
+    const_iterator begin() const;
+    const_iterator end() const;
+    const_iterator lower_bound(string_view english) const;
+    const_iterator upper_bound(string_view english) const;
+    pair<const_iterator, const_iterator> equal_range(string_view english) const;
+    Range prefix(string_view start) const;
     bool operator==(const Vocabulary& other) const;
     bool operator!=(const Vocabulary& other) const;
     friend ostream& operator<<(ostream& out, const Vocabulary& vocabulary);
     friend istream& operator>>(istream& in, Vocabulary& vocabulary);
     void printVocabulary(ostream& out) const;
     bool loadFromFile(const string& filename);
-    bool saveToFile(const string& filename) const;
+    bool saveToFile(const string& filename, VocabularyFormat format = VocabularyFormat::Text) const;
+    bool saveToFile(const string& filename, const SaveOptions& options) const;
 
 
 };
 
-#endif 
\ No newline at end of file
+class Vocabulary::const_iterator{
+    private:
+    const Vocabulary* owner_;
+    uint32_t index_;
+    friend class Vocabulary;
+    const_iterator(const Vocabulary* owner, uint32_t index) : owner_(owner), index_(index){}
+    public:
+    using iterator_category = bidirectional_iterator_tag;
+    using value_type = Entry;
+    using difference_type = ptrdiff_t;
+    using pointer = const Entry*;
+    using reference = const Entry&;
+    const_iterator() : owner_(nullptr), index_(NIL){}
+    reference operator*() const { return owner_->nodes_[index_]; }
+    pointer operator->() const { return &owner_->nodes_[index_]; }
+    const_iterator& operator++() { index_ = owner_->successor(index_); return *this; }
+    const_iterator operator++(int) { const_iterator copy = *this; ++*this; return copy; }
+    const_iterator& operator--() { index_ = owner_->predecessor(index_); return *this; }
+    const_iterator operator--(int) { const_iterator copy = *this; --*this; return copy; }
+    bool operator==(const const_iterator& other) const { return index_ == other.index_ && owner_ == other.owner_; }
+    bool operator!=(const const_iterator& other) const { return !(*this == other); }
+};
+
+// Ленивый диапазон: ничего не копирует, границы вычисляются один раз
+class Vocabulary::Range{
+    private:
+    const_iterator first_;
+    const_iterator last_;
+    public:
+    Range(const_iterator first, const_iterator last) : first_(first), last_(last){}
+    const_iterator begin() const { return first_; }
+    const_iterator end() const { return last_; }
+    bool empty() const { return first_ == last_; }
+};
+
+template <typename Visitor>
+void Vocabulary::visitInOrder(Visitor visit) const{
+    vector<uint32_t> path;
+    uint32_t current = root_;
+    while(current != NIL || !path.empty()){
+        while(current != NIL){
+            path.push_back(current);
+            current = nodes_[current].left;
+        }
+        current = path.back();
+        path.pop_back();
+        visit(nodes_[current]);
+        current = nodes_[current].right;
+    }
+}
+
+#endif
@@ -0,0 +1,328 @@
+#include "gtest/gtest.h"
+#include "../src/buffered_writer.h"
+#include "../src/vocabulary.h"
+#include <string>
+#include <fstream>
+#include <sstream>
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <iterator>
+#include <thread>
+#include <dirent.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+string readAll(const string& filename) {
+    ifstream file(filename, ios::binary);
+    stringstream content;
+    content << file.rdbuf();
+    return content.str();
+}
+
+bool fileExists(const string& filename) {
+    return access(filename.c_str(), F_OK) == 0;
+}
+
+// Временные файлы атомарной записи: "<имя>.XXXXXX" в текущем каталоге
+vector<string> temporaryFiles(const string& filename) {
+    vector<string> names;
+    DIR* directory = opendir(".");
+    if (!directory) return names;
+    string prefix = filename + ".";
+    while (dirent* entry = readdir(directory)) {
+        string name = entry->d_name;
+        if (name.size() == prefix.size() + 6 && name.compare(0, prefix.size(), prefix) == 0) {
+            names.push_back(name);
+        }
+    }
+    closedir(directory);
+    return names;
+}
+
+}
+
+class BufferedWriterTest : public ::testing::Test {
+protected:
+    void TearDown() override {
+        remove(filename.c_str());
+        remove((filename + ".tmp").c_str());
+        for (const string& name : temporaryFiles(filename)) remove(name.c_str());
+    }
+
+    const string filename = "test_writer.txt";
+};
+
+TEST(Crc32Test, KnownValues) {
+    EXPECT_EQ(crc32("", 0), 0u);
+    EXPECT_EQ(crc32("123456789", 9), 0xCBF43926u);
+    // Сумма считается по частям так же, как целиком
+    uint32_t crc = crc32("12345", 5);
+    EXPECT_EQ(crc32("6789", 4, crc), 0xCBF43926u);
+}
+
+TEST_F(BufferedWriterTest, WritesThroughSmallBuffer) {
+    BufferedWriter writer(7);
+    ASSERT_TRUE(writer.open(filename));
+    string expected;
+    for (int i = 0; i < 1000; ++i) {
+        string line = "word" + to_string(i);
+        writer.write(line);
+        writer.put('\n');
+        expected += line + "\n";
+    }
+    EXPECT_NE(writer.temporaryName(), filename);
+    EXPECT_TRUE(fileExists(writer.temporaryName()));
+    ASSERT_TRUE(writer.commit());
+    EXPECT_FALSE(writer.isOpen());
+    EXPECT_TRUE(temporaryFiles(filename).empty());
+    EXPECT_EQ(readAll(filename), expected);
+}
+
+TEST_F(BufferedWriterTest, AbortKeepsOldFile) {
+    {
+        ofstream old(filename);
+        old << "old content\n";
+    }
+    {
+        BufferedWriter writer;
+        ASSERT_TRUE(writer.open(filename));
+        writer.write("new content\n");
+        writer.abort();
+    }
+    EXPECT_TRUE(temporaryFiles(filename).empty());
+    EXPECT_EQ(readAll(filename), "old content\n");
+
+    // Незавершенная запись откатывается и в деструкторе
+    {
+        BufferedWriter writer;
+        ASSERT_TRUE(writer.open(filename));
+        writer.write("new content\n");
+    }
+    EXPECT_TRUE(temporaryFiles(filename).empty());
+    EXPECT_EQ(readAll(filename), "old content\n");
+}
+
+TEST_F(BufferedWriterTest, NonAtomicWritesInPlace) {
+    BufferedWriter writer;
+    ASSERT_TRUE(writer.open(filename, false));
+    writer.write("direct\n");
+    EXPECT_EQ(writer.temporaryName(), filename);
+    ASSERT_TRUE(writer.commit());
+    EXPECT_TRUE(temporaryFiles(filename).empty());
+    EXPECT_EQ(readAll(filename), "direct\n");
+}
+
+// Файл с именем "<имя>.tmp" — чужой: атомарная запись его не трогает
+TEST_F(BufferedWriterTest, AtomicKeepsUnrelatedTmpFile) {
+    {
+        ofstream other(filename + ".tmp");
+        other << "someone else\n";
+    }
+    BufferedWriter writer;
+    ASSERT_TRUE(writer.open(filename));
+    writer.write("new\n");
+    ASSERT_TRUE(writer.commit());
+    EXPECT_EQ(readAll(filename + ".tmp"), "someone else\n");
+    EXPECT_EQ(readAll(filename), "new\n");
+}
+
+TEST_F(BufferedWriterTest, ConcurrentSavesUseSeparateFiles) {
+    BufferedWriter first(4);
+    BufferedWriter second(4);
+    ASSERT_TRUE(first.open(filename));
+    ASSERT_TRUE(second.open(filename));
+    EXPECT_NE(first.temporaryName(), second.temporaryName());
+    string firstContent, secondContent;
+    for (int i = 0; i < 100; ++i) {
+        string line = "first" + to_string(i) + "\n";
+        first.write(line);
+        firstContent += line;
+        line = "second" + to_string(i) + "\n";
+        second.write(line);
+        secondContent += line;
+    }
+    ASSERT_TRUE(first.commit());
+    EXPECT_EQ(readAll(filename), firstContent);
+    ASSERT_TRUE(second.commit());
+    EXPECT_EQ(readAll(filename), secondContent);
+}
+
+TEST_F(BufferedWriterTest, AtomicKeepsTargetMode) {
+    {
+        ofstream old(filename);
+        old << "old\n";
+    }
+    ASSERT_EQ(chmod(filename.c_str(), 0600), 0);
+    BufferedWriter writer;
+    ASSERT_TRUE(writer.open(filename));
+    writer.write("new\n");
+    ASSERT_TRUE(writer.commit());
+    struct stat info;
+    ASSERT_EQ(stat(filename.c_str(), &info), 0);
+    EXPECT_EQ(info.st_mode & 07777, 0600u);
+
+    remove(filename.c_str());
+    ASSERT_TRUE(writer.open(filename));
+    ASSERT_TRUE(writer.commit());
+    ASSERT_EQ(stat(filename.c_str(), &info), 0);
+    EXPECT_EQ(info.st_mode & 07777, 0644u);
+}
+
+// Сигнал без SA_RESTART прерывает заблокированный write в канал: запись
+// должна продолжиться, а не оборваться
+TEST_F(BufferedWriterTest, RetriesInterruptedWrites) {
+    const string fifo = "test_writer.fifo";
+    remove(fifo.c_str());
+    ASSERT_EQ(mkfifo(fifo.c_str(), 0600), 0);
+    struct sigaction action = {};
+    struct sigaction previous;
+    action.sa_handler = [](int) {};
+    sigemptyset(&action.sa_mask);
+    ASSERT_EQ(sigaction(SIGUSR1, &action, &previous), 0);
+
+    string expected;
+    for (int i = 0; expected.size() < (3 << 20); ++i) {
+        expected += "line" + to_string(i) + "\n";
+    }
+    string received;
+    thread reader([&]() {
+        ifstream in(fifo, ios::binary);
+        this_thread::sleep_for(chrono::milliseconds(200));
+        received.assign(istreambuf_iterator<char>(in), istreambuf_iterator<char>());
+    });
+    BufferedWriter writer(1 << 16);
+    ASSERT_TRUE(writer.open(fifo, false));
+    pthread_t target = pthread_self();
+    atomic<bool> done(false);
+    thread signaler([&]() {
+        while (!done) {
+            this_thread::sleep_for(chrono::milliseconds(15));
+            pthread_kill(target, SIGUSR1);
+        }
+    });
+    // Мелкие куски идут через буфер, большой — напрямую
+    writer.write(expected.data(), 1 << 20);
+    for (size_t position = 1 << 20; position < expected.size(); position += 1000) {
+        writer.write(expected.substr(position, 1000));
+    }
+    writer.commit();
+    done = true;
+    signaler.join();
+    reader.join();
+    sigaction(SIGUSR1, &previous, nullptr);
+    remove(fifo.c_str());
+    EXPECT_EQ(received.size(), expected.size());
+    EXPECT_TRUE(received == expected);
+}
+
+TEST_F(BufferedWriterTest, OpenFailsForMissingDirectory) {
+    BufferedWriter writer;
+    EXPECT_FALSE(writer.open("no_such_dir/file.txt"));
+    EXPECT_FALSE(writer.isOpen());
+    EXPECT_FALSE(writer.commit());
+}
+
+class VocabularyChecksumTest : public BufferedWriterTest {
+protected:
+    void SetUp() override {
+        for (int i = 0; i < 5000; ++i) {
+            vac += {"word" + to_string(i), "слово" + to_string(i)};
+        }
+    }
+
+    SaveOptions checksummed() const {
+        SaveOptions options;
+        options.checksums = true;
+        options.checksumChunk = 4096;
+        return options;
+    }
+
+    Vocabulary vac;
+};
+
+TEST_F(VocabularyChecksumTest, RoundTrip) {
+    ASSERT_TRUE(vac.saveToFile(filename, checksummed()));
+    string content = readAll(filename);
+    EXPECT_NE(content.find("#crc32 "), string::npos);
+    EXPECT_EQ(content.rfind("#end 5000\n"), content.size() - 10);
+
+    Vocabulary loaded;
+    ASSERT_TRUE(loaded.loadFromFile(filename));
+    EXPECT_TRUE(loaded == vac);
+}
+
+TEST_F(VocabularyChecksumTest, PlainTextUnchanged) {
+    ASSERT_TRUE(vac.saveToFile(filename));
+    string content = readAll(filename);
+    EXPECT_EQ(content.find('#'), string::npos);
+    EXPECT_EQ(content.substr(0, content.find('\n') + 1), "word0 слово0\n");
+
+    Vocabulary loaded;
+    ASSERT_TRUE(loaded.loadFromFile(filename));
+    EXPECT_TRUE(loaded == vac);
+}
+
+TEST_F(VocabularyChecksumTest, DirectiveLikeWordsRoundTrip) {
+    Vocabulary words;
+    words += {"#crc32", "5"};
+    words += {"#end", "1"};
+    words += {"#crc32x", "5ab"};
+    words += {"#vocabulary", "checksums"};
+    words += {"plain", "обычный"};
+    for (bool checksums : {false, true}) {
+        SaveOptions options = checksummed();
+        options.checksums = checksums;
+        options.checksumChunk = 1;
+        ASSERT_TRUE(words.saveToFile(filename, options));
+        Vocabulary loaded;
+        ASSERT_TRUE(loaded.loadFromFile(filename)) << checksums;
+        EXPECT_TRUE(loaded == words) << checksums;
+    }
+}
+
+TEST_F(VocabularyChecksumTest, DetectsTruncation) {
+    ASSERT_TRUE(vac.saveToFile(filename, checksummed()));
+    string content = readAll(filename);
+    {
+        ofstream file(filename, ios::binary | ios::trunc);
+        file << content.substr(0, content.size() / 2);
+    }
+    Vocabulary loaded;
+    loaded += {"keep", "оставить"};
+    EXPECT_FALSE(loaded.loadFromFile(filename));
+    // При ошибке словарь не меняется
+    EXPECT_EQ(loaded.size(), 1u);
+    EXPECT_EQ(loaded["keep"], "оставить");
+}
+
+TEST_F(VocabularyChecksumTest, DetectsCorruption) {
+    ASSERT_TRUE(vac.saveToFile(filename, checksummed()));
+    string content = readAll(filename);
+    size_t position = content.find("word42 ");
+    ASSERT_NE(position, string::npos);
+    content[position + 4] = '7';
+    {
+        ofstream file(filename, ios::binary | ios::trunc);
+        file << content;
+    }
+    Vocabulary loaded;
+    EXPECT_FALSE(loaded.loadFromFile(filename));
+    EXPECT_TRUE(loaded.empty());
+}
+
+TEST_F(VocabularyChecksumTest, BinaryIsAtomicToo) {
+    SaveOptions options;
+    options.format = VocabularyFormat::Binary;
+    ASSERT_TRUE(vac.saveToFile(filename, options));
+    EXPECT_TRUE(temporaryFiles(filename).empty());
+    Vocabulary loaded;
+    ASSERT_TRUE(loaded.loadFromFile(filename));
+    EXPECT_TRUE(loaded == vac);
+}
@@ -0,0 +1,107 @@
+#include "gtest/gtest.h"
+#include "../src/concurrent_vocabulary.h"
+#include <string>
+#include <thread>
+#include <atomic>
+#include <vector>
+
+using namespace std;
+
+TEST(ConcurrentVocabularyTest, AddFindRemove) {
+    ConcurrentVocabulary words;
+    words += {"hello", "привет"};
+    words += {"world", "мир"};
+
+    string russian;
+    EXPECT_TRUE(words.find("hello", russian));
+    EXPECT_EQ(russian, "привет");
+    EXPECT_TRUE(words.contains("world"));
+    EXPECT_EQ(words.size(), 2u);
+
+    words -= "hello";
+    EXPECT_FALSE(words.find("hello", russian));
+    EXPECT_EQ(words.size(), 1u);
+}
+
+TEST(ConcurrentVocabularyTest, InitialVocabularyIsCopied) {
+    Vocabulary initial;
+    initial += {"cat", "кот"};
+
+    ConcurrentVocabulary words(initial);
+    initial += {"dog", "собака"};
+
+    EXPECT_TRUE(words.contains("cat"));
+    EXPECT_FALSE(words.contains("dog"));
+    EXPECT_EQ(words.read([](const Vocabulary& snapshot) { return snapshot["cat"]; }), "кот");
+}
+
+TEST(ConcurrentVocabularyTest, ChangesArePublishedInBatches) {
+    ConcurrentVocabulary words(3);
+    words += {"one", "один"};
+    words += {"two", "два"};
+    EXPECT_EQ(words.pendingCount(), 2u);
+    EXPECT_EQ(words.size(), 0u);
+
+    words -= "one";
+    EXPECT_EQ(words.pendingCount(), 0u);
+    EXPECT_EQ(words.size(), 1u);
+    EXPECT_FALSE(words.contains("one"));
+
+    words += {"three", "три"};
+    words.flush();
+    EXPECT_EQ(words.pendingCount(), 0u);
+    EXPECT_TRUE(words.snapshot() == words.read([](const Vocabulary& snapshot) { return snapshot; }));
+    EXPECT_EQ(words.size(), 2u);
+}
+
+// Читатели работают параллельно с писателем: постоянные слова всегда видны
+// с правильным переводом, а снимок никогда не бывает частично обновленным
+TEST(ConcurrentVocabularyTest, StressReadersWithWriter) {
+    Vocabulary initial;
+    for (int i = 0; i < 200; ++i) {
+        initial += {"stable" + to_string(i), "постоянное" + to_string(i)};
+    }
+    ConcurrentVocabulary words(initial, 4);
+
+    atomic<bool> stop(false);
+    atomic<size_t> errors(0);
+    atomic<size_t> reads(0);
+    vector<thread> readers;
+    for (int r = 0; r < 4; ++r) {
+        readers.emplace_back([&, r]() {
+            string russian;
+            size_t i = r;
+            while (!stop.load()) {
+                size_t key = i++ % 200;
+                if (!words.find("stable" + to_string(key), russian) ||
+                    russian != "постоянное" + to_string(key)) {
+                    ++errors;
+                }
+                // Пары temp/pair добавляются и удаляются одним пакетом
+                bool consistent = words.read([](const Vocabulary& snapshot) {
+                    return snapshot.contains("temp") == snapshot.contains("pair");
+                });
+                if (!consistent) ++errors;
+                ++reads;
+            }
+        });
+    }
+
+    for (int round = 0; round < 500; ++round) {
+        words += {"temp", "временное"};
+        words += {"pair", "пара"};
+        words += {"dynamic" + to_string(round), "динамическое"};
+        words -= "dynamic" + to_string(round - 1);
+        words -= "temp";
+        words -= "pair";
+        words += {"other" + to_string(round % 7), "другое"};
+        words -= "other" + to_string((round + 3) % 7);
+    }
+    while (reads.load() < 1000) this_thread::yield();
+    stop = true;
+    for (thread& reader : readers) reader.join();
+
+    EXPECT_EQ(errors.load(), 0u);
+    EXPECT_TRUE(words.contains("dynamic499"));
+    EXPECT_FALSE(words.contains("dynamic498"));
+}
@@ -0,0 +1,133 @@
+#include "gtest/gtest.h"
+#include "../src/mapped_vocabulary.h"
+#include "../src/vocabulary.h"
+#include <string>
+#include <fstream>
+#include <cstring>
+#include <iterator>
+
+using namespace std;
+
+class MappedVocabularyTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        vac += {"hello", "привет"};
+        vac += {"world", "мир"};
+        vac += {"apple", "яблоко"};
+        vac += {"ice cream", "мороженое"};
+        vac += {"thank you", "спасибо большое"};
+        ASSERT_TRUE(vac.saveToFile(filename, VocabularyFormat::Binary));
+    }
+
+    void TearDown() override {
+        remove(filename.c_str());
+    }
+
+    Vocabulary vac;
+    const string filename = "test_vocab.bin";
+};
+
+TEST_F(MappedVocabularyTest, OpenAndFind) {
+    MappedVocabulary mapped;
+    ASSERT_TRUE(mapped.open(filename));
+    EXPECT_TRUE(mapped.isOpen());
+    EXPECT_EQ(mapped.size(), 5u);
+
+    string_view russian;
+    ASSERT_TRUE(mapped.find("apple", russian));
+    EXPECT_EQ(russian, "яблоко");
+    EXPECT_FALSE(mapped.find("banana", russian));
+    EXPECT_TRUE(mapped.contains("world"));
+    EXPECT_EQ(mapped["hello"], "привет");
+    EXPECT_EQ(mapped["nonexistent"], "");
+}
+
+TEST_F(MappedVocabularyTest, MultiWordEntries) {
+    MappedVocabulary mapped;
+    ASSERT_TRUE(mapped.open(filename));
+
+    EXPECT_EQ(mapped["ice cream"], "мороженое");
+    EXPECT_EQ(mapped["thank you"], "спасибо большое");
+}
+
+TEST_F(MappedVocabularyTest, EntriesAreSorted) {
+    MappedVocabulary mapped;
+    ASSERT_TRUE(mapped.open(filename));
+
+    for (size_t i = 1; i < mapped.size(); ++i) {
+        EXPECT_LT(mapped.englishAt(i - 1), mapped.englishAt(i));
+    }
+}
+
+TEST_F(MappedVocabularyTest, LoadBinaryIntoVocabulary) {
+    EXPECT_TRUE(MappedVocabulary::isBinaryFile(filename));
+
+    Vocabulary loaded;
+    ASSERT_TRUE(loaded.loadFromFile(filename));
+    EXPECT_TRUE(loaded == vac);
+    EXPECT_EQ(loaded["ice cream"], "мороженое");
+}
+
+// Запись со смещением за пределами блока строк: поиск просто не находит
+// слово, а загрузка в Vocabulary отказывается от всего файла
+TEST_F(MappedVocabularyTest, LoadRejectsEntryOutsideStrings) {
+    string content;
+    {
+        ifstream file(filename, ios::binary);
+        content.assign(istreambuf_iterator<char>(file), istreambuf_iterator<char>());
+    }
+    VocabularyFileEntry entry;
+    size_t position = sizeof(VocabularyFileHeader) + 2 * sizeof(VocabularyFileEntry);
+    memcpy(&entry, &content[position], sizeof(entry));
+    entry.russianOffset = 1u << 30;
+    memcpy(&content[position], &entry, sizeof(entry));
+    {
+        ofstream file(filename, ios::binary | ios::trunc);
+        file << content;
+    }
+
+    MappedVocabulary mapped;
+    ASSERT_TRUE(mapped.open(filename));
+    EXPECT_FALSE(mapped.entryValid(2));
+    EXPECT_TRUE(mapped.entryValid(0));
+
+    Vocabulary loaded;
+    loaded += {"keep", "оставить"};
+    EXPECT_FALSE(loaded.loadFromFile(filename));
+    EXPECT_EQ(loaded.size(), 1u);
+    EXPECT_EQ(loaded["keep"], "оставить");
+}
+
+TEST_F(MappedVocabularyTest, MoveTransfersMapping) {
+    MappedVocabulary mapped;
+    ASSERT_TRUE(mapped.open(filename));
+
+    MappedVocabulary moved(std::move(mapped));
+    EXPECT_FALSE(mapped.isOpen());
+    EXPECT_EQ(moved["world"], "мир");
+
+    moved.close();
+    EXPECT_FALSE(moved.isOpen());
+    EXPECT_EQ(moved.size(), 0u);
+    EXPECT_EQ(moved["world"], "");
+}
+
+TEST_F(MappedVocabularyTest, RejectsInvalidFiles) {
+    MappedVocabulary mapped;
+    EXPECT_FALSE(mapped.open("nonexistent_file.bin"));
+
+    ofstream text("test_vocab.txt");
+    text << "red красный\n";
+    text.close();
+    EXPECT_FALSE(MappedVocabulary::isBinaryFile("test_vocab.txt"));
+    EXPECT_FALSE(mapped.open("test_vocab.txt"));
+    remove("test_vocab.txt");
+
+    // Обрезанный файл: заголовок обещает больше записей, чем есть
+    ofstream truncated("test_truncated.bin", ios::binary);
+    VocabularyFileHeader header = {{'V', 'O', 'C', 'B'}, VOCABULARY_FILE_VERSION, 1000};
+    truncated.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    truncated.close();
+    EXPECT_FALSE(mapped.open("test_truncated.bin"));
+    remove("test_truncated.bin");
+}
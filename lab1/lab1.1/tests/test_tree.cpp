@@ -134,4 +134,96 @@ TEST_F(TreeTest, SaveToFile) {
     file.close();
     
     remove("test_tree.txt");
-}
\ No newline at end of file
+}
+
+TEST_F(TreeTest, AddNodeBalancedRotates) {
+    Tree* root = new Tree("a", "а");
+    root = root->addNodeBalanced("b", "б");
+    root = root->addNodeBalanced("c", "в");
+
+    EXPECT_EQ(root->getEnglish(), "b");
+    EXPECT_EQ(root->getLeft()->getEnglish(), "a");
+    EXPECT_EQ(root->getRight()->getEnglish(), "c");
+    EXPECT_EQ(root->getHeight(), 2);
+
+    // Повторный ключ не добавляется и не меняет перевод
+    root = root->addNodeBalanced("b", "другое");
+    EXPECT_EQ(root->countNodeTree(), 3);
+    EXPECT_EQ(root->findNode("b")->getRussian(), "б");
+
+    delete root;
+}
+
+TEST_F(TreeTest, BalancedHeightOnSortedInput) {
+    Tree* root = new Tree("key00000", "0");
+    const int count = 1 << 14;
+    for (int i = 1; i < count; ++i) {
+        string key = to_string(i);
+        key = "key" + string(5 - key.size(), '0') + key;
+        root = root->addNodeBalanced(key, to_string(i));
+    }
+
+    EXPECT_EQ(root->countNodeTree(), count);
+    // Высота АВЛ-дерева не превышает 1.44 * log2(n)
+    EXPECT_LE(root->getHeight(), 21);
+
+    for (int i = 0; i < count; i += 2) {
+        string key = to_string(i);
+        key = "key" + string(5 - key.size(), '0') + key;
+        root = root->deleteNodeBalanced(key);
+    }
+
+    EXPECT_EQ(root->countNodeTree(), count / 2);
+    EXPECT_LE(root->getHeight(), 20);
+    EXPECT_EQ(root->findNode("key00000"), nullptr);
+    ASSERT_NE(root->findNode("key00001"), nullptr);
+    EXPECT_EQ(root->findNode("key00001")->getRussian(), "1");
+
+    delete root;
+}
+
+// Вырожденное дерево-цепочка из отсортированного ввода: все обходы
+// должны работать без переполнения стека вызовов
+TEST_F(TreeTest, DegenerateChainIsStackSafe) {
+    const int count = 5000000;
+    Tree* chain = new Tree("k0000000", "0");
+    Tree* last = chain;
+    char key[] = "k0000000";
+    for (int i = 1; i < count; ++i) {
+        for (int digit = 7; digit >= 1; --digit) {
+            if (++key[digit] <= '9') break;
+            key[digit] = '0';
+        }
+        Tree* next = new Tree(key, "п");
+        last->setRight(next);
+        last = next;
+    }
+
+    EXPECT_EQ(chain->countNodeTree(), count);
+
+    Tree* copy = new Tree(*chain);
+    EXPECT_TRUE(*copy == *chain);
+    last->setRussian("изменено");
+    EXPECT_FALSE(*copy == *chain);
+    EXPECT_EQ(copy->countNodeTree(), count);
+    delete copy;
+
+    EXPECT_TRUE(chain->saveToFile("test_chain.txt"));
+    ifstream file("test_chain.txt");
+    size_t lines = 0;
+    string line, lastLine;
+    while (getline(file, line)) {
+        lastLine = line;
+        ++lines;
+    }
+    EXPECT_EQ(lastLine, "k4999999 изменено");
+    EXPECT_EQ(lines, static_cast<size_t>(count));
+    file.close();
+    remove("test_chain.txt");
+
+    stringstream ss;
+    chain->printTree(ss);
+    EXPECT_EQ(ss.str().substr(0, 13), "k0000000 - 0\n");
+
+    delete chain;
+}
@@ -1,11 +1,39 @@
 #include "gtest/gtest.h"
 #include "../src/vocabulary.h"
+#include "../src/tree.h"
 #include <string>
 #include <sstream>
 #include <fstream>
+#include <atomic>
+#include <cstdlib>
+#include <new>
 
 using namespace std;
 
+// Счетчик выделений памяти для проверки поиска без аллокаций. Замена
+// operator new действует на весь тестовый бинарник, поэтому счетчик читается
+// только в StringViewLookupDoesNotAllocate и только как разность.
+// Замещающие operator new/delete работают через malloc/free, о чем GCC предупреждает зря.
+static atomic<size_t> allocationCount(0);
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+
+void* operator new(size_t size) {
+    ++allocationCount;
+    if (void* memory = malloc(size ? size : 1)) return memory;
+    throw bad_alloc();
+}
+
+void operator delete(void* memory) noexcept {
+    free(memory);
+}
+
+void operator delete(void* memory, size_t) noexcept {
+    free(memory);
+}
+#pragma GCC diagnostic pop
+
 class VocabularyTest : public ::testing::Test {
 protected:
     void SetUp() override {
@@ -20,7 +48,8 @@ protected:
 // Тест конструкторов
 TEST_F(VocabularyTest, Constructors) {
     Vocabulary empty;
-    EXPECT_EQ(empty.getRoot(), nullptr);
+    EXPECT_TRUE(empty.empty());
+    EXPECT_EQ(empty.size(), 0u);
     
     Vocabulary copy(vac);
     EXPECT_FALSE(copy == empty);
@@ -192,13 +221,469 @@ TEST_F(VocabularyTest, EdgeCases) {
     
     // Операции с пустым словарем
     empty -= "word";
-    EXPECT_EQ(empty.getRoot(), nullptr);
+    EXPECT_TRUE(empty.empty());
     
     // Добавление в пустой словарь
     empty += {"first", "первый"};
-    EXPECT_NE(empty.getRoot(), nullptr);
+    EXPECT_FALSE(empty.empty());
     
     // Удаление единственного элемента
     empty -= "first";
-    EXPECT_EQ(empty.getRoot(), nullptr);
-}
\ No newline at end of file
+    EXPECT_TRUE(empty.empty());
+}
+// Тест балансировки при отсортированном вводе
+TEST_F(VocabularyTest, SortedInputStaysBalanced) {
+    stringstream ss;
+    for (int i = 0; i < 10000; ++i) {
+        ss << "word" << 100000 + i << " слово" << i << "\n";
+    }
+
+    Vocabulary sorted;
+    ss >> sorted;
+
+    EXPECT_EQ(sorted.size(), 10000u);
+    EXPECT_LE(sorted.height(), 20);
+    EXPECT_EQ(sorted["word100042"], "слово42");
+
+    for (int i = 0; i < 10000; i += 3) {
+        sorted -= "word" + to_string(100000 + i);
+    }
+    EXPECT_EQ(sorted.size(), 10000u - 3334u);
+    EXPECT_LE(sorted.height(), 20);
+    EXPECT_EQ(sorted["word100003"], "");
+    EXPECT_EQ(sorted["word100004"], "слово4");
+}
+
+// Тест повторного использования узлов арены и копирования
+TEST_F(VocabularyTest, ArenaReuseAndCopy) {
+    Vocabulary arena;
+    for (int i = 0; i < 1000; ++i) {
+        arena += {"w" + to_string(i), "с" + to_string(i)};
+    }
+    for (int i = 0; i < 1000; i += 2) {
+        arena -= "w" + to_string(i);
+    }
+    size_t usedBefore = arena.memoryUsage();
+    for (int i = 0; i < 1000; i += 2) {
+        arena += {"w" + to_string(i), "н" + to_string(i)};
+    }
+    // Освобожденные узлы переиспользуются, массив не растет
+    EXPECT_EQ(arena.memoryUsage(), usedBefore);
+    EXPECT_EQ(arena.size(), 1000u);
+
+    Vocabulary copy(arena);
+    EXPECT_TRUE(copy == arena);
+    copy["w1"] = "изменено";
+    EXPECT_EQ(copy["w1"], "изменено");
+    EXPECT_EQ(arena["w1"], "с1");
+    EXPECT_TRUE(copy != arena);
+}
+
+// Тест сравнения по содержимому, а не по форме дерева
+TEST_F(VocabularyTest, EqualityIgnoresInsertionOrder) {
+    Vocabulary reversed;
+    reversed += {"world", "мир"};
+    reversed += {"hello", "привет"};
+    reversed += {"apple", "яблоко"};
+
+    EXPECT_TRUE(vac == reversed);
+}
+
+// Сравнение объема памяти арены и узлов Tree
+TEST_F(VocabularyTest, MemoryFootprintBelowPointerTree) {
+    Vocabulary big;
+    for (int i = 0; i < 4096; ++i) {
+        big += {"word" + to_string(i), "слово"};
+    }
+    // Узел Tree — отдельный блок malloc (минимум 16 байт служебных данных)
+    size_t pointerTreeBytes = big.size() * (sizeof(Tree) + 16);
+    EXPECT_LT(Vocabulary::nodeSize(), sizeof(Tree));
+    EXPECT_LT(big.memoryUsage(), pointerTreeBytes);
+}
+
+// Тест пакетной загрузки: то же содержимое, что и при поочередном добавлении
+TEST_F(VocabularyTest, BulkLoadMatchesIncremental) {
+    vector<pair<string, string>> pairs;
+    Vocabulary incremental;
+    unsigned seed = 12345;
+    for (int i = 0; i < 5000; ++i) {
+        seed = seed * 1103515245u + 12345u;
+        string english = "w" + to_string((seed >> 8) % 3000);
+        string russian = "п" + to_string(i);
+        pairs.emplace_back(english, russian);
+        incremental += {english, russian};
+    }
+
+    Vocabulary bulk(pairs);
+    EXPECT_TRUE(bulk == incremental);
+    EXPECT_EQ(bulk.size(), incremental.size());
+
+    // Высота минимально возможная: ceil(log2(n + 1))
+    int optimal = 0;
+    while ((size_t(1) << optimal) < bulk.size() + 1) ++optimal;
+    EXPECT_EQ(bulk.height(), optimal);
+
+    // После пакетной загрузки дерево остается рабочим
+    bulk -= pairs[0].first;
+    bulk += {"zzz", "последний"};
+    EXPECT_EQ(bulk["zzz"], "последний");
+    EXPECT_EQ(bulk[pairs[0].first], "");
+}
+
+// Тест ввода из потока в непустой словарь
+TEST_F(VocabularyTest, InputOperatorKeepsExistingWords) {
+    stringstream ss("hello здравствуй\ncat кот\n");
+    ss >> vac;
+
+    EXPECT_EQ(vac.size(), 4u);
+    EXPECT_EQ(vac["hello"], "привет");
+    EXPECT_EQ(vac["cat"], "кот");
+}
+
+// Небольшой ввод в большой словарь: повторы во вводе и со словарем
+// разрешаются так же, как при пакетной загрузке
+TEST_F(VocabularyTest, InputOperatorAppendsToLargeVocabulary) {
+    Vocabulary big;
+    for (int i = 0; i < 1000; ++i) {
+        big += {"word" + to_string(i), "слово" + to_string(i)};
+    }
+    stringstream ss("zebra зебра\nword5 другое\napple яблоко\nzebra конь\n");
+    ss >> big;
+
+    EXPECT_EQ(big.size(), 1002u);
+    EXPECT_EQ(big["word5"], "слово5");
+    EXPECT_EQ(big["zebra"], "зебра");
+    EXPECT_EQ(big["apple"], "яблоко");
+    string previous;
+    for (const Vocabulary::Entry& entry : big) {
+        EXPECT_LT(previous, entry.english);
+        previous = entry.english;
+    }
+    // Граница высоты АВЛ-дерева: 1.44 * log2(n + 2)
+    EXPECT_LE(big.height(), 14);
+}
+
+// Тест поиска по string_view без выделения памяти
+TEST_F(VocabularyTest, StringViewLookupDoesNotAllocate) {
+    Vocabulary big;
+    for (int i = 0; i < 1000; ++i) {
+        big += {"a_rather_long_english_word_" + to_string(i), "довольно длинный перевод " + to_string(i)};
+    }
+    const Vocabulary& constBig = big;
+    const char buffer[] = "a_rather_long_english_word_500 a_rather_long_english_word_999 missing";
+    string_view tokens[] = {string_view(buffer, 30), string_view(buffer + 31, 30), string_view(buffer + 62, 7)};
+
+    size_t found = 0;
+    size_t before = allocationCount.load();
+    for (int round = 0; round < 100; ++round) {
+        for (string_view token : tokens) {
+            if (const string* russian = constBig.find(token)) found += russian->size();
+            found += constBig.contains(token);
+            found += constBig[token].size();
+            if (string* russian = big.find(token)) found += russian->size();
+        }
+    }
+    EXPECT_EQ(allocationCount.load(), before);
+    EXPECT_GT(found, 0u);
+
+    EXPECT_EQ(*constBig.find("a_rather_long_english_word_500"), "довольно длинный перевод 500");
+    EXPECT_EQ(constBig.find("missing"), nullptr);
+}
+
+// Тест изменения перевода через неконстантный operator[]
+TEST_F(VocabularyTest, SubscriptReturnsReferenceIntoNode) {
+    vac["hello"] = "здравствуй";
+    EXPECT_EQ(vac["hello"], "здравствуй");
+
+    string* russian = vac.find("world");
+    ASSERT_NE(russian, nullptr);
+    *russian = "вселенная";
+    EXPECT_EQ(vac["world"], "вселенная");
+
+    vac["added"] = "добавлено";
+    EXPECT_TRUE(vac.contains("added"));
+    EXPECT_EQ(vac.size(), 4u);
+}
+
+// Тест пакетного перевода: совпадает с поочередным поиском
+TEST_F(VocabularyTest, BatchTranslateMatchesLookup) {
+    vector<pair<string, string>> pairs;
+    for (int i = 0; i < 2000; i += 2) {
+        pairs.emplace_back("w" + to_string(i), "п" + to_string(i));
+    }
+    Vocabulary big(pairs);
+
+    vector<string> storage;
+    unsigned seed = 7;
+    for (int i = 0; i < 200000; ++i) {
+        seed = seed * 1103515245u + 12345u;
+        storage.push_back("w" + to_string((seed >> 8) % 2100));
+    }
+    vector<string_view> tokens(storage.begin(), storage.end());
+
+    vector<const string*> single = big.translate(tokens);
+    vector<const string*> parallel = big.translate(tokens, 4);
+    ASSERT_EQ(single.size(), tokens.size());
+    for (size_t i = 0; i < tokens.size(); ++i) {
+        EXPECT_EQ(single[i], big.find(tokens[i]));
+        EXPECT_EQ(parallel[i], single[i]);
+    }
+
+    EXPECT_TRUE(big.translate(vector<string_view>()).empty());
+    Vocabulary empty;
+    EXPECT_EQ(empty.translate({"any"})[0], nullptr);
+}
+
+// Тест итераторов: обход по возрастанию в обе стороны
+TEST_F(VocabularyTest, OrderedIteration) {
+    vector<string> forward;
+    for (const Vocabulary::Entry& entry : vac) {
+        forward.push_back(entry.english);
+    }
+    EXPECT_EQ(forward, (vector<string>{"apple", "hello", "world"}));
+
+    vector<string> backward;
+    for (auto it = vac.end(); it != vac.begin();) {
+        --it;
+        backward.push_back(it->english);
+    }
+    EXPECT_EQ(backward, (vector<string>{"world", "hello", "apple"}));
+
+    Vocabulary empty;
+    EXPECT_TRUE(empty.begin() == empty.end());
+
+    // Итератор работает и после вращений при удалении
+    Vocabulary big;
+    for (int i = 0; i < 3000; ++i) big += {"k" + to_string(100000 + i), "з"};
+    for (int i = 0; i < 3000; i += 3) big -= "k" + to_string(100000 + i);
+    size_t count = 0;
+    string previous;
+    for (const auto& entry : big) {
+        EXPECT_LT(previous, entry.english);
+        previous = entry.english;
+        ++count;
+    }
+    EXPECT_EQ(count, big.size());
+    EXPECT_EQ(distance(big.begin(), big.end()), static_cast<ptrdiff_t>(big.size()));
+}
+
+// Тест поиска границ и диапазонов
+TEST_F(VocabularyTest, BoundsAndRanges) {
+    EXPECT_EQ(vac.lower_bound("hello")->english, "hello");
+    EXPECT_EQ(vac.lower_bound("b")->english, "hello");
+    EXPECT_EQ(vac.upper_bound("hello")->english, "world");
+    EXPECT_TRUE(vac.lower_bound("zzz") == vac.end());
+
+    auto found = vac.equal_range("apple");
+    ASSERT_TRUE(found.first != found.second);
+    EXPECT_EQ(found.first->russian, "яблоко");
+    EXPECT_TRUE(++found.first == found.second);
+
+    auto missing = vac.equal_range("banana");
+    EXPECT_TRUE(missing.first == missing.second);
+}
+
+// Тест выборки по началу слова
+TEST_F(VocabularyTest, PrefixQuery) {
+    Vocabulary words;
+    for (const char* english : {"car", "card", "care", "cart", "cat", "ca", "c", "dog", "carb"}) {
+        words += {english, "перевод"};
+    }
+
+    vector<string> matched;
+    for (const auto& entry : words.prefix("car")) {
+        matched.push_back(entry.english);
+    }
+    EXPECT_EQ(matched, (vector<string>{"car", "carb", "card", "care", "cart"}));
+
+    EXPECT_TRUE(words.prefix("x").empty());
+    EXPECT_TRUE(words.prefix("cars").empty());
+    size_t all = 0;
+    for (auto it = words.prefix("").begin(); it != words.prefix("").end(); ++it) ++all;
+    EXPECT_EQ(all, words.size());
+    EXPECT_EQ(distance(words.prefix("c").begin(), words.prefix("c").end()), 8);
+}
+
+// Тест индекса Eytzinger: те же результаты, что и у дерева
+TEST_F(VocabularyTest, EytzingerBackendMatchesTree) {
+    Vocabulary tree;
+    Vocabulary eytzinger(VocabularyBackend::Eytzinger);
+    EXPECT_EQ(eytzinger.backend(), VocabularyBackend::Eytzinger);
+    EXPECT_EQ(eytzinger.find("missing"), nullptr);
+
+    unsigned seed = 99;
+    vector<string> keys;
+    for (int i = 0; i < 3000; ++i) {
+        seed = seed * 1103515245u + 12345u;
+        // Короткие ключи, ключи с общим 8-байтовым началом и префиксы друг друга
+        string key = (i % 3 == 0) ? to_string(seed % 1000)
+                   : (i % 3 == 1) ? "commonprefix" + to_string(seed % 500)
+                   : string("commonpr").substr(0, seed % 9);
+        keys.push_back(key);
+        tree += {key, "п" + to_string(i)};
+        eytzinger += {key, "п" + to_string(i)};
+        if (i % 5 == 0) {
+            tree -= keys[seed % keys.size()];
+            eytzinger -= keys[seed % keys.size()];
+        }
+        if (i % 7 == 0) {
+            const string& probe = keys[(seed >> 4) % keys.size()];
+            EXPECT_EQ(eytzinger.contains(probe), tree.contains(probe));
+        }
+    }
+    EXPECT_TRUE(eytzinger == tree);
+
+    eytzinger.reindex();
+    for (const string& key : keys) {
+        EXPECT_EQ(eytzinger[key], static_cast<const Vocabulary&>(tree)[key]) << key;
+        EXPECT_EQ(eytzinger.contains(key + "x"), tree.contains(key + "x"));
+    }
+    EXPECT_EQ(eytzinger.contains(""), tree.contains(""));
+
+    // После пакетной загрузки индекс готов сразу
+    vector<pair<string, string>> pairs = {{"b", "б"}, {"a", "а"}, {"c", "в"}};
+    Vocabulary bulk(pairs, VocabularyBackend::Eytzinger);
+    EXPECT_EQ(*bulk.find("a"), "а");
+    bulk["d"] = "г";
+    EXPECT_EQ(bulk["d"], "г");
+    EXPECT_EQ(bulk.find("e"), nullptr);
+}
+
+// Тест кэша частых слов: счетчики, вытеснение и сброс при удалении
+TEST_F(VocabularyTest, FrontCache) {
+    const Vocabulary& constVac = vac;
+    EXPECT_EQ(vac.cacheCapacity(), 0u);
+    vac.setCacheCapacity(6);
+    EXPECT_EQ(vac.cacheCapacity(), 8u);
+
+    EXPECT_EQ(constVac["hello"], "привет");
+    EXPECT_EQ(constVac["hello"], "привет");
+    EXPECT_EQ(constVac["missing"], "");
+    Vocabulary::CacheStats stats = vac.cacheStats();
+    EXPECT_EQ(stats.hits, 1u);
+    EXPECT_EQ(stats.misses, 2u);
+
+    // Изменение перевода через operator[] видно через кэш
+    vac["hello"] = "здравствуй";
+    EXPECT_EQ(constVac["hello"], "здравствуй");
+
+    // Удаление сбрасывает запись: и самого слова, и переехавшего преемника
+    EXPECT_EQ(constVac["world"], "мир");
+    vac -= "hello";
+    EXPECT_EQ(constVac.find("hello"), nullptr);
+    EXPECT_EQ(constVac["world"], "мир");
+    vac -= "apple";
+    vac += {"apple", "другое яблоко"};
+    EXPECT_EQ(constVac["apple"], "другое яблоко");
+
+    vac.resetCacheStats();
+    EXPECT_EQ(vac.cacheStats().hits, 0u);
+}
+
+TEST_F(VocabularyTest, FrontCacheStaysConsistentUnderChurn) {
+    Vocabulary cached;
+    Vocabulary plain;
+    cached.setCacheCapacity(64);
+    unsigned seed = 3;
+    for (int i = 0; i < 20000; ++i) {
+        seed = seed * 1103515245u + 12345u;
+        string key = "k" + to_string((seed >> 8) % 300);
+        switch (seed % 4) {
+            case 0:
+                cached += {key, to_string(i)};
+                plain += {key, to_string(i)};
+                break;
+            case 1:
+                cached -= key;
+                plain -= key;
+                break;
+            default: {
+                const string* expected = static_cast<const Vocabulary&>(plain).find(key);
+                const string* actual = static_cast<const Vocabulary&>(cached).find(key);
+                ASSERT_EQ(actual == nullptr, expected == nullptr) << key;
+                if (actual) {
+                    EXPECT_EQ(*actual, *expected);
+                }
+            }
+        }
+    }
+    Vocabulary::CacheStats stats = cached.cacheStats();
+    EXPECT_GT(stats.hits, 0u);
+    EXPECT_GT(stats.evictions, 0u);
+    EXPECT_TRUE(cached == plain);
+
+    cached.clear();
+    EXPECT_EQ(static_cast<const Vocabulary&>(cached).find("k1"), nullptr);
+}
+
+TEST(VocabularyMergeTest, ConflictPolicies) {
+    Vocabulary master({{"apple", "яблоко"}, {"cat", "кот"}, {"dog", "собака"}});
+    Vocabulary delta({{"bird", "птица"}, {"cat", "кошка"}, {"zebra", "зебра"}});
+
+    Vocabulary kept = master;
+    kept.merge(delta);
+    EXPECT_EQ(kept.size(), 5u);
+    EXPECT_EQ(kept["cat"], "кот");
+    EXPECT_EQ(kept["bird"], "птица");
+    EXPECT_EQ(kept["zebra"], "зебра");
+
+    Vocabulary overwritten = master;
+    overwritten.merge(delta, ConflictPolicy::Overwrite);
+    EXPECT_EQ(overwritten.size(), 5u);
+    EXPECT_EQ(overwritten["cat"], "кошка");
+    EXPECT_EQ(overwritten["apple"], "яблоко");
+
+    // Источник не меняется
+    EXPECT_EQ(delta.size(), 3u);
+    EXPECT_EQ(delta["cat"], "кошка");
+}
+
+TEST(VocabularyMergeTest, EmptyAndSelf) {
+    Vocabulary words({{"one", "один"}, {"two", "два"}});
+    Vocabulary empty;
+    words.merge(empty);
+    EXPECT_EQ(words.size(), 2u);
+    words.merge(words, ConflictPolicy::Overwrite);
+    EXPECT_EQ(words.size(), 2u);
+    empty.merge(words);
+    EXPECT_TRUE(empty == words);
+}
+
+TEST(VocabularyMergeTest, MatchesSingleInsertsAndIsBalanced) {
+    Vocabulary master;
+    Vocabulary delta;
+    Vocabulary expected;
+    // Удаления оставляют дыры в массиве узлов и свободный список
+    for (int i = 0; i < 100000; ++i) {
+        string key = "w" + to_string(i * 7919 % 100003);
+        if (i % 3 == 0) delta += {key, "delta" + to_string(i)};
+        if (i % 2 == 0) master += {key, "master" + to_string(i)};
+    }
+    for (int i = 0; i < 100000; i += 10) master -= "w" + to_string(i * 7919 % 100003);
+    expected = master;
+    for (const Vocabulary::Entry& node : delta) expected += {node.english, node.russian};
+
+    for (size_t threads : {1u, 3u, 8u}) {
+        Vocabulary merged = master;
+        merged.merge(delta, ConflictPolicy::KeepExisting, threads);
+        EXPECT_TRUE(merged == expected) << threads;
+        EXPECT_LE(merged.height(), 18) << threads;
+        EXPECT_TRUE(merged.contains("w0"));
+        // После слияния дерево остается обычным: вставка и удаление работают
+        merged += {"zzz", "конец"};
+        EXPECT_EQ(merged.size(), expected.size() + 1);
+        merged -= "w0";
+        EXPECT_FALSE(merged.contains("w0"));
+        EXPECT_EQ(merged.size(), expected.size());
+    }
+}
+
+TEST(VocabularyMergeTest, EytzingerBackend) {
+    Vocabulary master({{"b", "2"}, {"d", "4"}}, VocabularyBackend::Eytzinger);
+    Vocabulary delta({{"a", "1"}, {"c", "3"}, {"d", "четыре"}});
+    master.merge(delta, ConflictPolicy::Overwrite, 2);
+    ASSERT_NE(master.find("c"), nullptr);
+    EXPECT_EQ(*master.find("c"), "3");
+    EXPECT_EQ(*master.find("d"), "четыре");
+    EXPECT_EQ(master.find("e"), nullptr);
+}
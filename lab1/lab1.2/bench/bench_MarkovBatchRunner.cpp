@@ -0,0 +1,59 @@
+#include <benchmark/benchmark.h>
+#include "../src/MarkovBatchRunner.h"
+#include <random>
+
+using namespace std;
+
+// 20000 лент для сложения в унарной системе: отдельная машина с loadProgram
+// на каждую ленту против пакетного прогона одной скомпилированной программы.
+// 100 служебных правил, которые на этих лентах не срабатывают, делают
+// программу похожей по размеру на настоящие
+static MarkovProgram batchProgram() {
+    MarkovProgram program;
+    for (int i = 0; i < 100; ++i) {
+        program.addRule(MarkovRule("#" + to_string(i) + "|", "|#" + to_string(i)));
+    }
+    program.addRule(MarkovRule("|+", "+|", false));
+    program.addRule(MarkovRule("+", "", true));
+    return program;
+}
+
+static vector<string> batchTapes() {
+    mt19937 generator(3);
+    vector<string> tapes;
+    for (int i = 0; i < 20000; ++i) {
+        tapes.push_back(string(generator() % 40, '|') + "+" + string(generator() % 40, '|'));
+    }
+    return tapes;
+}
+
+static void BM_BatchMachinePerTape(benchmark::State& state) {
+    MarkovProgram program = batchProgram();
+    vector<string> tapes = batchTapes();
+    for (auto _ : state) {
+        size_t steps = 0;
+        for (const string& tape : tapes) {
+            MarkovMachine machine;
+            machine.loadProgram(program);
+            machine.loadTape(tape);
+            while (machine.step()) {}
+            steps += machine.getCurrentStep();
+        }
+        benchmark::DoNotOptimize(steps);
+    }
+    state.SetItemsProcessed(state.iterations() * tapes.size());
+}
+BENCHMARK(BM_BatchMachinePerTape)->Unit(benchmark::kMillisecond);
+
+static void BM_BatchRunner(benchmark::State& state) {
+    shared_ptr<const MarkovCompiledProgram> compiled = MarkovCompiledProgram::compile(batchProgram());
+    vector<string> tapes = batchTapes();
+    MarkovBatchOptions options;
+    options.threads = state.range(0);
+    MarkovBatchRunner runner(compiled, options);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(runner.run(tapes));
+    }
+    state.SetItemsProcessed(state.iterations() * tapes.size());
+}
+BENCHMARK(BM_BatchRunner)->Arg(1)->Arg(4)->Unit(benchmark::kMillisecond)->UseRealTime();
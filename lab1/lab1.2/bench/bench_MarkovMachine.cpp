@@ -0,0 +1,34 @@
+#include <benchmark/benchmark.h>
+#include "../src/MarkovMachine.h"
+#include <string>
+
+using namespace std;
+
+// Полный run по числу правил и длине ленты: рабочие правила "*a" -> "b*" и
+// "*" -> "", за ними ruleCount - 2 правил, которые не срабатывают, но входят в
+// автомат; шагов столько же, сколько байт ленты. Несработавшие правила перед
+// рабочими заставляют каждый шаг просматривать всю ленту — это BM_RunAlternating
+static MarkovProgram runProgram(size_t ruleCount) {
+    MarkovProgram program;
+    program.addRule(MarkovRule("*a", "b*"));
+    program.addRule(MarkovRule("*", "", true));
+    for (size_t i = 0; i + 2 < ruleCount; ++i) {
+        program.addRule(MarkovRule("#" + to_string(i) + "#", "x"));
+    }
+    return program;
+}
+
+static void BM_MachineRun(benchmark::State& state) {
+    size_t ruleCount = state.range(0);
+    string tape = "*" + string(state.range(1) - 1, 'a');
+    MarkovMachine machine;
+    machine.loadProgram(runProgram(ruleCount));
+    for (auto _ : state) {
+        machine.loadTape(tape);
+        benchmark::DoNotOptimize(machine.run(MarkovRunOptions()).steps);
+    }
+    state.SetItemsProcessed(state.iterations() * tape.size());
+}
+BENCHMARK(BM_MachineRun)
+    ->ArgsProduct({{2, 64, 1024}, {1 << 10, 1 << 14, 1 << 18}})
+    ->ArgNames({"rules", "tape"})->Unit(benchmark::kMillisecond);
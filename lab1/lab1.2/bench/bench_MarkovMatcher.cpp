@@ -0,0 +1,245 @@
+#include <benchmark/benchmark.h>
+#include "../src/MarkovMatcher.h"
+#include "../src/MarkovMachine.h"
+#include "../src/MarkovSearch.h"
+#include <random>
+
+using namespace std;
+
+// Программа из ruleCount правил вида "<1-4 буквы a-h>*": маркер, как в типичных
+// нормальных алгоритмах. Лента 1 МБ из тех же букв без маркера, в конце —
+// образец последнего правила с другим маркером "#", поэтому перебору
+// приходится искать каждое правило по всей ленте
+static MarkovProgram benchProgram(size_t ruleCount) {
+    mt19937 generator(11);
+    MarkovProgram program;
+    while (program.getRuleCount() < static_cast<int>(ruleCount)) {
+        string pattern;
+        size_t length = 1 + generator() % 4;
+        for (size_t i = 0; i < length; ++i) pattern += static_cast<char>('a' + generator() % 8);
+        pattern += program.getRuleCount() + 1 == static_cast<int>(ruleCount) ? '#' : '*';
+        program.addRule(MarkovRule(pattern, "x"));
+    }
+    return program;
+}
+
+static string benchTape(const MarkovProgram& program, size_t length) {
+    mt19937 generator(5);
+    string tape;
+    tape.reserve(length);
+    while (tape.size() < length) tape += static_cast<char>('a' + generator() % 8);
+    const string& last = program.getRule(program.getRuleCount() - 1).getPattern();
+    tape.replace(tape.size() - last.size(), last.size(), last);
+    return tape;
+}
+
+static void BM_FindReference(benchmark::State& state) {
+    MarkovProgram program = benchProgram(state.range(0));
+    string tape = benchTape(program, state.range(1));
+    for (auto _ : state) {
+        int found = -1;
+        for (int i = 0; i < program.getRuleCount() && found < 0; ++i) {
+            if (tape.find(program.getRule(i).getPattern()) != string::npos) found = i;
+        }
+        benchmark::DoNotOptimize(found);
+    }
+    state.SetBytesProcessed(state.iterations() * tape.size());
+}
+BENCHMARK(BM_FindReference)->Args({200, 1 << 20})->Args({20, 1 << 20})->Unit(benchmark::kMillisecond);
+
+static void BM_FindCompiled(benchmark::State& state) {
+    MarkovProgram program = benchProgram(state.range(0));
+    string tape = benchTape(program, state.range(1));
+    MarkovMatcher matcher(program);
+    for (auto _ : state) {
+        MarkovMatch match;
+        benchmark::DoNotOptimize(matcher.find(tape, match));
+    }
+    state.SetBytesProcessed(state.iterations() * tape.size());
+}
+BENCHMARK(BM_FindCompiled)->Args({200, 1 << 20})->Args({20, 1 << 20})->Unit(benchmark::kMillisecond);
+
+static void BM_Compile(benchmark::State& state) {
+    MarkovProgram program = benchProgram(state.range(0));
+    for (auto _ : state) {
+        MarkovMatcher matcher(program);
+        benchmark::DoNotOptimize(matcher.stateCount());
+    }
+}
+BENCHMARK(BM_Compile)->Arg(200)->Unit(benchmark::kMicrosecond);
+
+// Полный шаг машины на ленте 1 МБ: поиск плюс замена
+static void BM_MachineStep(benchmark::State& state) {
+    MarkovProgram program = benchProgram(state.range(0));
+    string tape = benchTape(program, state.range(1));
+    MarkovMachine machine;
+    machine.loadProgram(program);
+    for (auto _ : state) {
+        state.PauseTiming();
+        machine.loadTape(tape);
+        state.ResumeTiming();
+        benchmark::DoNotOptimize(machine.step());
+    }
+}
+BENCHMARK(BM_MachineStep)->Args({200, 1 << 20})->Unit(benchmark::kMillisecond);
+
+// Маркер проходит по ленте, удлиняя ее на каждом шаге: "*a" -> "bb*".
+// Строковая лента сдвигает весь хвост на каждой замене, буфер с разрывом —
+// только байты между соседними правками; поиск продолжается от места замены
+static void BM_RunMarkerWalk(benchmark::State& state) {
+    MarkovTapeKind kind = static_cast<MarkovTapeKind>(state.range(0));
+    size_t tail = state.range(1);
+    MarkovProgram program;
+    program.addRule(MarkovRule("*a", "bb*"));
+    program.addRule(MarkovRule("*", "", true));
+    string tape = "*" + string(10000, 'a') + string(tail, 'c');
+    MarkovMachine machine(kind);
+    machine.loadProgram(program);
+    for (auto _ : state) {
+        machine.loadTape(tape);
+        while (machine.step()) {}
+        benchmark::DoNotOptimize(machine.getCurrentStep());
+    }
+    state.SetItemsProcessed(state.iterations() * 10001);
+}
+BENCHMARK(BM_RunMarkerWalk)
+    ->ArgsProduct({{static_cast<int>(MarkovTapeKind::String), static_cast<int>(MarkovTapeKind::GapBuffer)},
+                   {1 << 10, 1 << 16, 1 << 20}})
+    ->ArgNames({"tape", "tail"})->Unit(benchmark::kMillisecond);
+
+// Два правила по очереди: "*a" -> "#b", затем "#b" -> "b*". После первого правила
+// ни одно правило с номером <= 0 не находится рядом с правкой, и режим Scan
+// проходит всю ленту с начала, включая длинный префикс без вхождений.
+// Incremental пересматривает только окно вокруг правки
+static void BM_RunAlternating(benchmark::State& state) {
+    MarkovSearchMode mode = static_cast<MarkovSearchMode>(state.range(0));
+    size_t padding = state.range(1);
+    MarkovProgram program;
+    program.addRule(MarkovRule("*a", "#b"));
+    program.addRule(MarkovRule("#b", "b*"));
+    string tape = string(padding, 'x') + "*" + string(500, 'a');
+    MarkovMachine machine(MarkovTapeKind::GapBuffer, mode);
+    machine.loadProgram(program);
+    for (auto _ : state) {
+        machine.loadTape(tape);
+        while (machine.step()) {}
+        benchmark::DoNotOptimize(machine.getCurrentStep());
+    }
+    state.SetItemsProcessed(state.iterations() * 1000);
+}
+BENCHMARK(BM_RunAlternating)
+    ->ArgsProduct({{static_cast<int>(MarkovSearchMode::Scan), static_cast<int>(MarkovSearchMode::Incremental)},
+                   {1 << 12, 1 << 16, 1 << 20}})
+    ->ArgNames({"mode", "padding"})->Unit(benchmark::kMillisecond);
+
+// Цена ограничений прогона: тот же проход маркера с хешированием ленты и без
+static void BM_RunWithCycleDetection(benchmark::State& state) {
+    MarkovProgram program;
+    program.addRule(MarkovRule("*a", "bb*"));
+    program.addRule(MarkovRule("*", "", true));
+    string tape = "*" + string(10000, 'a') + string(1 << 16, 'c');
+    MarkovMachine machine;
+    machine.loadProgram(program);
+    MarkovRunOptions options;
+    options.detectCycles = state.range(0) != 0;
+    options.timeout = chrono::seconds(60);
+    for (auto _ : state) {
+        machine.loadTape(tape);
+        benchmark::DoNotOptimize(machine.run(options).steps);
+    }
+    state.SetItemsProcessed(state.iterations() * 10001);
+}
+BENCHMARK(BM_RunWithCycleDetection)->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond);
+
+// Журнал прогона: печать ленты после каждого шага (cout в пустой буфер)
+// против двоичной трассы в кольцевом буфере (mode 0 — без журнала, 1 — печать,
+// 2 — трасса). Печать стоит O(длина ленты) на шаг
+static void BM_RunLogging(benchmark::State& state) {
+    MarkovProgram program;
+    program.addRule(MarkovRule("*a", "bb*"));
+    program.addRule(MarkovRule("*", "", true));
+    string tape = "*" + string(10000, 'a') + string(1 << 12, 'c');
+    MarkovMachine machine;
+    machine.loadProgram(program);
+    MarkovTrace trace(1 << 16);
+    MarkovRunOptions options;
+    options.log = state.range(0) == 1;
+    options.trace = state.range(0) == 2 ? &trace : nullptr;
+    struct NullBuffer : streambuf {
+        int overflow(int symbol) override { return symbol; }
+        streamsize xsputn(const char*, streamsize count) override { return count; }
+    } null;
+    streambuf* saved = cout.rdbuf(&null);
+    for (auto _ : state) {
+        machine.loadTape(tape);
+        benchmark::DoNotOptimize(machine.run(options).steps);
+    }
+    cout.rdbuf(saved);
+    state.SetItemsProcessed(state.iterations() * 10001);
+}
+BENCHMARK(BM_RunLogging)->Arg(0)->Arg(1)->Arg(2)->ArgNames({"mode"})->Unit(benchmark::kMillisecond);
+
+// Один короткий образец в конце ленты 1 МБ: string::find против markovFind
+// с выбранным набором команд (0 — string::find, 1 — Scalar, 2 — SSE2, 3 — AVX2)
+static void BM_FindSinglePattern(benchmark::State& state) {
+    mt19937 generator(3);
+    string tape;
+    while (tape.size() < (1 << 20)) tape += static_cast<char>('a' + generator() % 8);
+    string pattern = string("ab").substr(0, state.range(1)) + "#";
+    tape.replace(tape.size() - pattern.size(), pattern.size(), pattern);
+    int mode = state.range(0);
+    if (mode > 0 && !markovSearchKernelSupported(static_cast<MarkovSearchKernel>(mode - 1))) {
+        state.SkipWithError("kernel is not supported");
+        return;
+    }
+    for (auto _ : state) {
+        size_t found = mode == 0 ? tape.find(pattern)
+                                 : markovFind(static_cast<MarkovSearchKernel>(mode - 1), tape, pattern);
+        benchmark::DoNotOptimize(found);
+    }
+    state.SetBytesProcessed(state.iterations() * tape.size());
+}
+BENCHMARK(BM_FindSinglePattern)->ArgsProduct({{0, 1, 2, 3}, {0, 2}})->ArgNames({"mode", "prefix"})
+    ->Unit(benchmark::kMicrosecond);
+
+// Кириллический алфавит: по байтам и в кодах алфавита программы. Маркер
+// проходит по ленте из двухбайтовых символов; в кодах лента вдвое короче
+static void BM_RunCyrillic(benchmark::State& state) {
+    MarkovEncoding encoding = static_cast<MarkovEncoding>(state.range(0));
+    MarkovProgram program;
+    program.addRule(MarkovRule("*а", "бб*"));
+    program.addRule(MarkovRule("*", "", true));
+    string tape = "*";
+    for (int i = 0; i < 10000; ++i) tape += "а";
+    for (int i = 0; i < (1 << 15); ++i) tape += "в";
+    MarkovMachine machine;
+    machine.loadProgram(program, encoding);
+    for (auto _ : state) {
+        machine.loadTape(tape);
+        benchmark::DoNotOptimize(machine.run(MarkovRunOptions()).steps);
+    }
+    state.SetItemsProcessed(state.iterations() * 10001);
+}
+BENCHMARK(BM_RunCyrillic)->Arg(0)->Arg(1)->ArgNames({"encoding"})->Unit(benchmark::kMillisecond);
+
+// Только поиск: автомат проходит всю кириллическую ленту 1 МБ символов
+static void BM_FindCyrillic(benchmark::State& state) {
+    MarkovEncoding encoding = static_cast<MarkovEncoding>(state.range(0));
+    MarkovProgram program;
+    program.addRule(MarkovRule("жжж", "ж"));
+    program.addRule(MarkovRule("ёа", "а"));
+    string tape;
+    mt19937 generator(7);
+    const char* letters[] = {"а", "б", "в", "г"};
+    for (int i = 0; i < (1 << 20); ++i) tape += letters[generator() % 4];
+    tape += "ёа";
+    auto compiled = MarkovCompiledProgram::compile(program, encoding);
+    string codes = tape, others;
+    if (compiled->getEncoding() == MarkovEncoding::Utf8) compiled->getAlphabet().encode(tape, codes, others);
+    for (auto _ : state) {
+        MarkovMatch match;
+        benchmark::DoNotOptimize(compiled->getMatcher().find(codes, match));
+    }
+    state.SetItemsProcessed(state.iterations() * (1 << 20));
+}
+BENCHMARK(BM_FindCyrillic)->Arg(0)->Arg(1)->ArgNames({"encoding"})->Unit(benchmark::kMillisecond);
@@ -0,0 +1,44 @@
+#include <benchmark/benchmark.h>
+#include "../src/MarkovProgram.h"
+#include <cstdio>
+#include <fstream>
+
+using namespace std;
+
+// Сгенерированная программа из ruleCount различных правил в файлах обоих форматов
+static MarkovProgram generatedProgram(size_t ruleCount) {
+    MarkovProgram program;
+    for (size_t i = 0; i < ruleCount; ++i) {
+        program.addRule(MarkovRule("p" + to_string(i) + "*", "r" + to_string(i * 7), i % 97 == 0));
+    }
+    return program;
+}
+
+static void BM_LoadStream(benchmark::State& state) {
+    generatedProgram(state.range(0)).saveToFile("bench_program.txt");
+    for (auto _ : state) {
+        ifstream file("bench_program.txt");
+        MarkovProgram program;
+        file >> program;
+        benchmark::DoNotOptimize(program.getRuleCount());
+    }
+    remove("bench_program.txt");
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_LoadStream)->Arg(50000)->Unit(benchmark::kMillisecond);
+
+static void BM_LoadFile(benchmark::State& state) {
+    MarkovProgramFormat format = static_cast<MarkovProgramFormat>(state.range(1));
+    generatedProgram(state.range(0)).saveToFile("bench_program.mkp", format);
+    for (auto _ : state) {
+        MarkovProgram program;
+        program.loadFromFile("bench_program.mkp");
+        benchmark::DoNotOptimize(program.getRuleCount());
+    }
+    remove("bench_program.mkp");
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_LoadFile)
+    ->Args({50000, static_cast<int>(MarkovProgramFormat::Text)})
+    ->Args({50000, static_cast<int>(MarkovProgramFormat::Binary)})
+    ->ArgNames({"rules", "format"})->Unit(benchmark::kMillisecond);
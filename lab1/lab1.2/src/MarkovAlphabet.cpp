@@ -0,0 +1,140 @@
+#include "MarkovAlphabet.h"
+#include <algorithm>
+#include <cstring>
+
+const uint8_t MarkovAlphabet::OTHER;
+
+namespace {
+
+size_t twoByteIndex(string_view symbol) {
+    return (static_cast<unsigned char>(symbol[0]) & 0x1F) << 6 | (static_cast<unsigned char>(symbol[1]) & 0x3F);
+}
+
+uint32_t packed(string_view symbol) {
+    uint32_t key = 0;
+    memcpy(&key, symbol.data(), symbol.size());
+    return key;
+}
+
+}
+
+MarkovAlphabet::MarkovAlphabet() : symbolOffset_(1, 0) {
+    for (int16_t& code : byteCode_) {
+        code = -1;
+    }
+    for (int16_t& code : twoByteCode_) {
+        code = -1;
+    }
+}
+
+size_t MarkovAlphabet::symbolLength(string_view text, size_t position) {
+    unsigned char lead = static_cast<unsigned char>(text[position]);
+    size_t length = lead < 0x80 ? 1 : lead >= 0xF0 && lead < 0xF8 ? 4 : lead >= 0xE0 ? 3 : lead >= 0xC0 ? 2 : 1;
+    if (length > 1 && (lead >= 0xF8 || position + length > text.size())) {
+        return 1;
+    }
+    for (size_t i = 1; i < length; ++i) {
+        if ((static_cast<unsigned char>(text[position + i]) & 0xC0) != 0x80) {
+            return 1;
+        }
+    }
+    return length;
+}
+
+int MarkovAlphabet::codeOf(string_view symbol) const {
+    if (symbol.size() == 1) {
+        return byteCode_[static_cast<unsigned char>(symbol[0])];
+    }
+    if (symbol.size() == 2) {
+        return twoByteCode_[twoByteIndex(symbol)];
+    }
+    auto found = multiByteCode_.find(packed(symbol));
+    return found == multiByteCode_.end() ? -1 : found->second;
+}
+
+bool MarkovAlphabet::build(const MarkovProgram& program) {
+    *this = MarkovAlphabet();
+    for (int i = 0; i < program.getRuleCount(); ++i) {
+        for (const string* text : {&program.getRule(i).getPattern(), &program.getRule(i).getReplacement()}) {
+            for (size_t position = 0; position < text->size();) {
+                string_view symbol = string_view(*text).substr(position, symbolLength(*text, position));
+                position += symbol.size();
+                if (codeOf(symbol) >= 0) {
+                    continue;
+                }
+                if (size() == OTHER) {
+                    return false;
+                }
+                uint8_t code = static_cast<uint8_t>(size());
+                if (symbol.size() == 1) {
+                    byteCode_[static_cast<unsigned char>(symbol[0])] = code;
+                } else if (symbol.size() == 2) {
+                    twoByteCode_[twoByteIndex(symbol)] = code;
+                } else {
+                    multiByteCode_.emplace(packed(symbol), code);
+                }
+                symbols_.append(symbol.data(), symbol.size());
+                symbolOffset_.push_back(static_cast<uint32_t>(symbols_.size()));
+            }
+        }
+    }
+    return true;
+}
+
+size_t MarkovAlphabet::size() const {
+    return symbolOffset_.size() - 1;
+}
+
+bool MarkovAlphabet::encodeProgramText(string_view text, string& codes) const {
+    string others;
+    encode(text, codes, others);
+    return others.empty();
+}
+
+void MarkovAlphabet::encode(string_view text, string& codes, string& others) const {
+    codes.resize(text.size());
+    others.clear();
+    char* out = &codes[0];
+    size_t count = 0;
+    for (size_t position = 0; position < text.size();) {
+        unsigned char lead = static_cast<unsigned char>(text[position]);
+        size_t length = lead < 0x80 ? 1 : symbolLength(text, position);
+        int code = length == 1 ? byteCode_[lead] : codeOf(text.substr(position, length));
+        if (code < 0) {
+            out[count++] = static_cast<char>(OTHER);
+            others += static_cast<char>(length);
+            others.append(text.data() + position, length);
+        } else {
+            out[count++] = static_cast<char>(code);
+        }
+        position += length;
+    }
+    codes.resize(count);
+}
+
+string MarkovAlphabet::decode(string_view codes, string_view others) const {
+    size_t length = others.size();
+    for (unsigned char code : codes) {
+        if (code != OTHER) {
+            length += symbolOffset_[code + 1] - symbolOffset_[code];
+        }
+    }
+    string text(length, '\0');
+    char* out = &text[0];
+    size_t other = 0;
+    for (unsigned char code : codes) {
+        if (code != OTHER) {
+            uint32_t offset = symbolOffset_[code];
+            uint32_t symbolLength = symbolOffset_[code + 1] - offset;
+            memcpy(out, symbols_.data() + offset, symbolLength);
+            out += symbolLength;
+        } else if (other < others.size()) {
+            size_t symbolLength = min<size_t>(static_cast<unsigned char>(others[other]), others.size() - other - 1);
+            memcpy(out, others.data() + other + 1, symbolLength);
+            out += symbolLength;
+            other += symbolLength + 1;
+        }
+    }
+    text.resize(out - text.data());
+    return text;
+}
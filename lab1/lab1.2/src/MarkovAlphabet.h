@@ -0,0 +1,51 @@
+#ifndef MARKOVALPHABET_H
+#define MARKOVALPHABET_H
+
+#include "MarkovProgram.h"
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+using namespace std;
+
+// Bytes — лента и образцы как есть, по байтам.
+// Utf8 — символы UTF-8 программы кодируются плотными однобайтовыми кодами:
+// образец не может совпасть с куском символа, лента короче, а автомат строится
+// по алфавиту программы
+enum class MarkovEncoding { Bytes, Utf8 };
+
+// Алфавит программы: не больше 255 символов UTF-8 с кодами 0..254.
+// Символы ленты, которых нет в программе, получают общий код OTHER, а их
+// байты с длиной впереди по порядку складываются в отдельную строку: правила
+// таких символов не создают и не удаляют, поэтому порядок сохраняется.
+// Некорректные байты UTF-8 считаются отдельными символами.
+class MarkovAlphabet {
+public:
+    static const uint8_t OTHER = 255;
+
+private:
+    int16_t byteCode_[256];
+    // Двухбайтовые символы (кириллица и т.п.) — прямой таблицей по 11 битам
+    int16_t twoByteCode_[1 << 11];
+    unordered_map<uint32_t, uint8_t> multiByteCode_;
+    string symbols_;
+    vector<uint32_t> symbolOffset_;
+    int codeOf(string_view symbol) const;
+
+public:
+    MarkovAlphabet();
+
+    // false, если символов больше 255
+    bool build(const MarkovProgram& program);
+    size_t size() const;
+
+    // Длина символа, начинающегося в text[position]
+    static size_t symbolLength(string_view text, size_t position);
+    // Кодирование строк программы: все символы должны быть в алфавите
+    bool encodeProgramText(string_view text, string& codes) const;
+    void encode(string_view text, string& codes, string& others) const;
+    string decode(string_view codes, string_view others) const;
+};
+
+#endif
@@ -0,0 +1,103 @@
+#include "MarkovBatchRunner.h"
+#include <algorithm>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+namespace {
+
+struct alignas(64) WorkQueue {
+    mutex lock;
+    deque<size_t> tasks;
+};
+
+bool popOwn(WorkQueue& queue, size_t& task) {
+    lock_guard<mutex> guard(queue.lock);
+    if (queue.tasks.empty()) {
+        return false;
+    }
+    task = queue.tasks.back();
+    queue.tasks.pop_back();
+    return true;
+}
+
+// Забирает у соседа старшую половину его очереди
+bool steal(WorkQueue& victim, WorkQueue& own, size_t& task) {
+    vector<size_t> stolen;
+    {
+        lock_guard<mutex> guard(victim.lock);
+        size_t count = (victim.tasks.size() + 1) / 2;
+        for (size_t i = 0; i < count; ++i) {
+            stolen.push_back(victim.tasks.front());
+            victim.tasks.pop_front();
+        }
+    }
+    if (stolen.empty()) {
+        return false;
+    }
+    task = stolen.back();
+    stolen.pop_back();
+    lock_guard<mutex> guard(own.lock);
+    own.tasks.insert(own.tasks.end(), stolen.begin(), stolen.end());
+    return true;
+}
+
+}
+
+MarkovBatchRunner::MarkovBatchRunner(shared_ptr<const MarkovCompiledProgram> program,
+                                     const MarkovBatchOptions& options)
+    : program_(std::move(program)), options_(options) {}
+
+vector<MarkovRunResult> MarkovBatchRunner::run(const vector<string>& tapes) const {
+    return run(tapes, vector<size_t>());
+}
+
+vector<MarkovRunResult> MarkovBatchRunner::run(const vector<string>& tapes, const vector<size_t>& maxSteps) const {
+    vector<MarkovRunResult> results(tapes.size());
+    size_t threads = options_.threads ? options_.threads : max(1u, thread::hardware_concurrency());
+    size_t workers = max<size_t>(1, min(threads, tapes.size()));
+
+    vector<WorkQueue> queues(workers);
+    for (size_t worker = 0; worker < workers; ++worker) {
+        for (size_t i = tapes.size() * worker / workers; i < tapes.size() * (worker + 1) / workers; ++i) {
+            queues[worker].tasks.push_back(i);
+        }
+    }
+
+    auto work = [&](size_t worker) {
+        MarkovMachine machine(options_.tapeKind, options_.searchMode);
+        machine.loadProgram(program_);
+        MarkovRunOptions runOptions = options_.run;
+        runOptions.log = false;
+        runOptions.trace = nullptr;
+        size_t task;
+        while (true) {
+            bool found = popOwn(queues[worker], task);
+            for (size_t k = 1; k < workers && !found; ++k) {
+                found = steal(queues[(worker + k) % workers], queues[worker], task);
+            }
+            if (!found) {
+                return;
+            }
+            if (task < maxSteps.size()) {
+                runOptions.maxSteps = maxSteps[task];
+            }
+            machine.loadTape(tapes[task]);
+            results[task] = machine.run(runOptions);
+            runOptions.maxSteps = options_.run.maxSteps;
+        }
+    };
+
+    if (workers == 1) {
+        work(0);
+        return results;
+    }
+    vector<thread> pool;
+    for (size_t worker = 0; worker < workers; ++worker) {
+        pool.emplace_back(work, worker);
+    }
+    for (thread& worker : pool) {
+        worker.join();
+    }
+    return results;
+}
@@ -0,0 +1,39 @@
+#ifndef MARKOVBATCHRUNNER_H
+#define MARKOVBATCHRUNNER_H
+
+#include "MarkovMachine.h"
+#include <vector>
+#include <cstdint>
+
+using namespace std;
+
+struct MarkovBatchOptions {
+    // 0 — по числу ядер
+    size_t threads = 0;
+    // Ограничения прогона каждой ленты; run.maxSteps действует, если для ленты
+    // не задан свой лимит. Печать шагов (run.log) и трасса (run.trace) в пакете
+    // не используются: потоки писали бы в одну трассу одновременно
+    MarkovRunOptions run;
+    MarkovTapeKind tapeKind = MarkovTapeKind::GapBuffer;
+    MarkovSearchMode searchMode = MarkovSearchMode::Scan;
+};
+
+// Прогон одной скомпилированной программы по множеству лент. Каждый поток
+// держит одну машину и лишь перезагружает в нее ленты. Ленты делятся между
+// потоками поровну; опустевший поток забирает половину очереди у соседа,
+// так что одна долгая лента не держит остальных.
+class MarkovBatchRunner {
+private:
+    shared_ptr<const MarkovCompiledProgram> program_;
+    MarkovBatchOptions options_;
+
+public:
+    explicit MarkovBatchRunner(shared_ptr<const MarkovCompiledProgram> program,
+                               const MarkovBatchOptions& options = MarkovBatchOptions());
+
+    vector<MarkovRunResult> run(const vector<string>& tapes) const;
+    // maxSteps[i] — лимит шагов для tapes[i]
+    vector<MarkovRunResult> run(const vector<string>& tapes, const vector<size_t>& maxSteps) const;
+};
+
+#endif
@@ -0,0 +1,103 @@
+#include "MarkovCompiledProgram.h"
+#include <unordered_map>
+
+namespace {
+
+// Смещение строки в пуле; одинаковые строки делят одно место
+uint32_t intern(string_view text, string& pool, unordered_map<string_view, uint32_t>& offsets) {
+    auto found = offsets.find(text);
+    if (found != offsets.end()) {
+        return found->second;
+    }
+    uint32_t offset = static_cast<uint32_t>(pool.size());
+    pool.append(text.data(), text.size());
+    offsets.emplace(text, offset);
+    return offset;
+}
+
+}
+
+// Пул и автомат строятся по программе в кодах алфавита, если он нужен.
+// Ключи словаря смотрят в строки source, которые живут до конца конструктора
+MarkovCompiledProgram::MarkovCompiledProgram(const MarkovProgram& program, MarkovEncoding encoding)
+    : program_(program), encoding_(MarkovEncoding::Bytes) {
+    MarkovProgram encoded;
+    if (encoding == MarkovEncoding::Utf8 && alphabet_.build(program_)) {
+        encoding_ = MarkovEncoding::Utf8;
+        string pattern, replacement;
+        for (int i = 0; i < program_.getRuleCount(); ++i) {
+            const MarkovRule& rule = program_.getRule(i);
+            alphabet_.encodeProgramText(rule.getPattern(), pattern);
+            alphabet_.encodeProgramText(rule.getReplacement(), replacement);
+            encoded.addRule(MarkovRule(pattern, replacement, rule.getIsFinal()));
+        }
+    }
+    const MarkovProgram& source = encoding_ == MarkovEncoding::Utf8 ? encoded : program_;
+    matcher_ = MarkovMatcher(source);
+
+    size_t ruleCount = source.getRuleCount();
+    size_t totalLength = 0;
+    for (size_t i = 0; i < ruleCount; ++i) {
+        totalLength += source.getRule(i).getPattern().size() + source.getRule(i).getReplacement().size();
+    }
+    pool_.reserve(totalLength);
+    rules_.reserve(ruleCount);
+    unordered_map<string_view, uint32_t> offsets;
+    offsets.reserve(2 * ruleCount);
+    for (size_t i = 0; i < ruleCount; ++i) {
+        const MarkovRule& rule = source.getRule(i);
+        MarkovCompiledRule compiled;
+        compiled.patternOffset = intern(rule.getPattern(), pool_, offsets);
+        compiled.patternLength = static_cast<uint32_t>(rule.getPattern().size());
+        compiled.replacementOffset = intern(rule.getReplacement(), pool_, offsets);
+        compiled.replacementLength = static_cast<uint32_t>(rule.getReplacement().size());
+        compiled.isFinal = rule.getIsFinal();
+        rules_.push_back(compiled);
+    }
+    pool_.shrink_to_fit();
+}
+
+shared_ptr<const MarkovCompiledProgram> MarkovCompiledProgram::compile(const MarkovProgram& program,
+                                                                       MarkovEncoding encoding) {
+    return make_shared<const MarkovCompiledProgram>(program, encoding);
+}
+
+MarkovEncoding MarkovCompiledProgram::getEncoding() const {
+    return encoding_;
+}
+
+const MarkovAlphabet& MarkovCompiledProgram::getAlphabet() const {
+    return alphabet_;
+}
+
+const MarkovProgram& MarkovCompiledProgram::getProgram() const {
+    return program_;
+}
+
+const MarkovMatcher& MarkovCompiledProgram::getMatcher() const {
+    return matcher_;
+}
+
+size_t MarkovCompiledProgram::ruleCount() const {
+    return rules_.size();
+}
+
+const MarkovCompiledRule& MarkovCompiledProgram::getRule(size_t index) const {
+    return rules_[index];
+}
+
+string_view MarkovCompiledProgram::pattern(size_t index) const {
+    return string_view(pool_.data() + rules_[index].patternOffset, rules_[index].patternLength);
+}
+
+string_view MarkovCompiledProgram::replacement(size_t index) const {
+    return string_view(pool_.data() + rules_[index].replacementOffset, rules_[index].replacementLength);
+}
+
+bool MarkovCompiledProgram::isFinal(size_t index) const {
+    return rules_[index].isFinal;
+}
+
+size_t MarkovCompiledProgram::poolSize() const {
+    return pool_.size();
+}
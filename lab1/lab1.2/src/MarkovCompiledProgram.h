@@ -0,0 +1,56 @@
+#ifndef MARKOVCOMPILEDPROGRAM_H
+#define MARKOVCOMPILEDPROGRAM_H
+
+#include "MarkovProgram.h"
+#include "MarkovMatcher.h"
+#include "MarkovAlphabet.h"
+#include <cstdint>
+#include <memory>
+#include <string_view>
+
+using namespace std;
+
+// Правило скомпилированной программы: образец и замена — куски общего пула строк
+struct MarkovCompiledRule {
+    uint32_t patternOffset;
+    uint32_t patternLength;
+    uint32_t replacementOffset;
+    uint32_t replacementLength;
+    bool isFinal;
+};
+
+// Неизменяемая программа вместе с автоматом по ее образцам. Компилируется
+// один раз и раздается машинам через shared_ptr: загрузка в машину ничего
+// не копирует, а читать ее можно из любого числа потоков одновременно.
+// Шаг машины читает правила из плотной таблицы и одного пула, где каждая
+// различная строка хранится один раз; MarkovProgram остается для getProgram().
+// В кодировке Utf8 пул, таблица и автомат — в кодах алфавита программы; если
+// символов больше 255, программа компилируется по байтам (см. getEncoding()).
+class MarkovCompiledProgram {
+private:
+    MarkovProgram program_;
+    MarkovEncoding encoding_;
+    MarkovAlphabet alphabet_;
+    string pool_;
+    vector<MarkovCompiledRule> rules_;
+    MarkovMatcher matcher_;
+
+public:
+    explicit MarkovCompiledProgram(const MarkovProgram& program, MarkovEncoding encoding = MarkovEncoding::Bytes);
+    static shared_ptr<const MarkovCompiledProgram> compile(const MarkovProgram& program,
+                                                           MarkovEncoding encoding = MarkovEncoding::Bytes);
+
+    const MarkovProgram& getProgram() const;
+    const MarkovMatcher& getMatcher() const;
+    MarkovEncoding getEncoding() const;
+    const MarkovAlphabet& getAlphabet() const;
+
+    size_t ruleCount() const;
+    const MarkovCompiledRule& getRule(size_t index) const;
+    string_view pattern(size_t index) const;
+    string_view replacement(size_t index) const;
+    bool isFinal(size_t index) const;
+    size_t poolSize() const;
+};
+
+#endif
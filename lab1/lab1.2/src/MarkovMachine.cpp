@@ -1,55 +1,292 @@
 #include "MarkovMachine.h"
+#include <algorithm>
 
-MarkovMachine::MarkovMachine() : currentStep_(0) {}
+namespace {
 
-void MarkovMachine::loadProgram(const MarkovProgram& program) {
-    program_ = program;
+// Пустая программа одна на все машины
+const shared_ptr<const MarkovCompiledProgram>& emptyProgram() {
+    static const shared_ptr<const MarkovCompiledProgram> program = MarkovCompiledProgram::compile(MarkovProgram());
+    return program;
+}
+
+}
+
+MarkovMachine::MarkovMachine() : MarkovMachine(MarkovTapeKind::GapBuffer) {}
+
+MarkovMachine::MarkovMachine(MarkovTapeKind tapeKind, MarkovSearchMode searchMode)
+    : tape_(MarkovTape::create(tapeKind)), tapeTextValid_(true),
+      program_(emptyProgram()), lastRule_(MarkovMatcher::NO_RULE),
+      lastPosition_(0), searchMode_(searchMode), indexValid_(false), hashing_(false), trace_(nullptr), currentStep_(0) {}
+
+MarkovMachine::MarkovMachine(const MarkovMachine& other)
+    : tape_(other.tape_->clone()), otherSymbols_(other.otherSymbols_), tapeText_(other.tapeText_),
+      tapeTextValid_(other.tapeTextValid_), program_(other.program_), lastRule_(other.lastRule_),
+      lastPosition_(other.lastPosition_), searchMode_(other.searchMode_), index_(other.index_),
+      indexValid_(other.indexValid_), hashing_(false), trace_(nullptr), currentStep_(other.currentStep_) {
+#ifdef MARKOV_PROFILE
+    profile_ = other.profile_;
+#endif
+}
+
+MarkovMachine& MarkovMachine::operator=(const MarkovMachine& other) {
+    if (this != &other) {
+        tape_ = other.tape_->clone();
+        otherSymbols_ = other.otherSymbols_;
+        tapeText_ = other.tapeText_;
+        tapeTextValid_ = other.tapeTextValid_;
+        program_ = other.program_;
+        lastRule_ = other.lastRule_;
+        lastPosition_ = other.lastPosition_;
+        searchMode_ = other.searchMode_;
+        index_ = other.index_;
+        indexValid_ = other.indexValid_;
+        currentStep_ = other.currentStep_;
+#ifdef MARKOV_PROFILE
+        profile_ = other.profile_;
+#endif
+    }
+    return *this;
+}
+
+void MarkovMachine::loadProgram(const MarkovProgram& program, MarkovEncoding encoding) {
+    loadProgram(MarkovCompiledProgram::compile(program, encoding));
+}
+
+// Лента в кодах старого алфавита перекодируется под новую программу
+void MarkovMachine::loadProgram(shared_ptr<const MarkovCompiledProgram> program) {
+    bool recode = program != program_ && tape_->size() > 0 &&
+                  (program->getEncoding() == MarkovEncoding::Utf8 || program_->getEncoding() == MarkovEncoding::Utf8);
+    string text = recode ? getTape() : string();
+    program_ = std::move(program);
+    if (recode) {
+        assignTape(text);
+    }
+    lastRule_ = MarkovMatcher::NO_RULE;
+    indexValid_ = false;
+#ifdef MARKOV_PROFILE
+    resetProfile();
+#endif
+}
+
+void MarkovMachine::assignTape(const string& text) {
+    if (program_->getEncoding() == MarkovEncoding::Utf8) {
+        string codes;
+        program_->getAlphabet().encode(text, codes, otherSymbols_);
+        tape_->assign(codes);
+    } else {
+        otherSymbols_.clear();
+        tape_->assign(text);
+    }
+    tapeTextValid_ = false;
 }
 
 void MarkovMachine::loadTape(const string& tape) {
-    tape_ = tape;
+    assignTape(tape);
+    lastRule_ = MarkovMatcher::NO_RULE;
+    indexValid_ = false;
     setCurrentStep(0);
 }
 
 const string& MarkovMachine::getTape() const {
-    return tape_;
+    if (!tapeTextValid_) {
+        tapeText_ = program_->getEncoding() == MarkovEncoding::Utf8
+                        ? program_->getAlphabet().decode(tape_->str(), otherSymbols_)
+                        : tape_->str();
+        tapeTextValid_ = true;
+    }
+    return tapeText_;
+}
+
+MarkovTapeKind MarkovMachine::getTapeKind() const {
+    return tape_->kind();
+}
+
+MarkovSearchMode MarkovMachine::getSearchMode() const {
+    return searchMode_;
 }
 
-int MarkovMachine::getCurrentStep() const {
+MarkovEncoding MarkovMachine::getEncoding() const {
+    return program_->getEncoding();
+}
+
+size_t MarkovMachine::getCurrentStep() const {
     return currentStep_;
 }
 
 const MarkovProgram& MarkovMachine::getProgram() const {
+    return program_->getProgram();
+}
+
+const shared_ptr<const MarkovCompiledProgram>& MarkovMachine::getCompiledProgram() const {
     return program_;
 }
 
-void MarkovMachine::setCurrentStep(int currentStep) {
+void MarkovMachine::setCurrentStep(size_t currentStep) {
     currentStep_ = currentStep;
 }
 
-bool MarkovMachine::step() {
-    for (int i = 0; i < getProgram().getRuleCount(); ++i) {
-        const MarkovRule& rule = getProgram().getRule(i);
-        int pos = getTape().find(rule.getPattern());
-        if (pos != string::npos) {
-            tape_.replace(pos, rule.getPattern().length(), rule.getReplacement());
-            setCurrentStep(getCurrentStep()+1);
-            return !rule.getIsFinal();
+#ifdef MARKOV_PROFILE
+const MarkovProfile& MarkovMachine::getProfile() const {
+    return profile_;
+}
+
+void MarkovMachine::resetProfile() {
+    profile_.reset(program_->ruleCount());
+}
+#endif
+
+// Если правило r применено в позиции p, то ни одно правило с номером меньше r
+// не имело вхождений, а у r не было вхождений левее p. Префикс до p не
+// изменился, поэтому новые вхождения правил с номером <= r начинаются не раньше
+// p - maxPatternLength + 1 (пустой образец r — в самой p): достаточно искать их оттуда.
+// Только если таких нет, нужен полный проход для остальных правил.
+bool MarkovMachine::findMatch(MarkovMatch& match) {
+    const MarkovMatcher& matcher = program_->getMatcher();
+    if (searchMode_ == MarkovSearchMode::Incremental) {
+        if (!indexValid_) {
+            index_.build(matcher, *tape_);
+            indexValid_ = true;
+        }
+        bool found = index_.first(matcher, match);
+#ifdef MARKOV_PROFILE
+        match.scanned = index_.takeScanned();
+#endif
+        return found;
+    }
+    if (lastRule_ != MarkovMatcher::NO_RULE) {
+        size_t window = max<size_t>(matcher.maxPatternLength(), 1);
+        size_t from = lastPosition_ + 1 > window ? lastPosition_ + 1 - window : 0;
+        if (matcher.find(*tape_, from, lastRule_ + 1, match)) {
+            return true;
         }
     }
-    return false; 
+#ifdef MARKOV_PROFILE
+    size_t restartScanned = lastRule_ != MarkovMatcher::NO_RULE ? match.scanned : 0;
+    bool found = matcher.find(*tape_, 0, MarkovMatcher::NO_RULE, match);
+    match.scanned += restartScanned;
+    return found;
+#else
+    return matcher.find(*tape_, 0, MarkovMatcher::NO_RULE, match);
+#endif
+}
+
+bool MarkovMachine::step() {
+    MarkovMatch match;
+    if (!findMatch(match)) {
+#ifdef MARKOV_PROFILE
+        profile_.recordNoMatch(match.scanned);
+#endif
+        lastRule_ = MarkovMatcher::NO_RULE;
+        return false;
+    }
+    const MarkovCompiledProgram& program = *program_;
+    string_view pattern = program.pattern(match.rule);
+    string_view replacement = program.replacement(match.rule);
+#ifdef MARKOV_PROFILE
+    profile_.recordMatch(match.rule, match.scanned, replacement.length());
+#endif
+    if (hashing_) {
+        hash_.replace(*tape_, match.position, pattern, replacement);
+    }
+    bool checkpoint = trace_ && trace_->record(getCurrentStep(), match.rule, match.position,
+                                               pattern.length(), replacement.length());
+    tape_->replace(match.position, pattern.length(), replacement);
+    tapeTextValid_ = false;
+    if (checkpoint) {
+        trace_->checkpoint(getTape(), getCurrentStep() + 1);
+    }
+    lastRule_ = match.rule;
+    lastPosition_ = match.position;
+    if (searchMode_ == MarkovSearchMode::Incremental) {
+        index_.update(program.getMatcher(), *tape_, match.position, pattern.length(), replacement.length());
+    }
+    setCurrentStep(getCurrentStep()+1);
+    return !program.isFinal(match.rule);
 }
 
 void MarkovMachine::run(bool log) {
-    if(log){
-        while (step()) {
+    MarkovRunOptions options;
+    options.log = log;
+    run(options);
+    if (!log) {
+        cout << *this << endl;
+    }
+}
+
+MarkovRunResult MarkovMachine::run(const MarkovRunOptions& options) {
+    const size_t NO_STEP = SIZE_MAX;
+    MarkovRunResult result;
+    result.reason = MarkovHaltReason::StepLimit;
+    result.cycleStart = 0;
+
+    vector<pair<uint64_t, size_t>> seen;
+    size_t mask = 0;
+    // Машина в начальном состоянии — для проверки совпавших хешей
+    unique_ptr<MarkovMachine> start;
+    if (options.detectCycles) {
+        start = make_unique<MarkovMachine>(*this);
+        size_t tableSize = 1;
+        while (tableSize < options.cycleTableSize) {
+            tableSize <<= 1;
+        }
+        seen.assign(tableSize, make_pair(uint64_t(0), NO_STEP));
+        mask = tableSize - 1;
+        hash_.reset(*tape_);
+        hashing_ = true;
+        seen[hash_.value() & mask] = make_pair(hash_.value(), getCurrentStep());
+    }
+    trace_ = options.trace;
+    if (trace_) {
+        trace_->begin(getTape(), getCurrentStep(), program_->getEncoding());
+    }
+
+    bool timed = options.timeout > chrono::steady_clock::duration::zero();
+    chrono::steady_clock::time_point deadline = timed ? chrono::steady_clock::now() + options.timeout
+                                                      : chrono::steady_clock::time_point::max();
+    for (size_t steps = 0;; ++steps) {
+        if (steps >= options.maxSteps) {
+            result.reason = MarkovHaltReason::StepLimit;
+            break;
+        }
+        if (timed && (steps & 255) == 0 && chrono::steady_clock::now() >= deadline) {
+            result.reason = MarkovHaltReason::Deadline;
+            break;
+        }
+        size_t before = getCurrentStep();
+        if (!step()) {
+            result.reason = getCurrentStep() > before ? MarkovHaltReason::FinalRule : MarkovHaltReason::NoRule;
+            break;
+        }
+        if (options.log) {
             cout << *this << endl;
         }
-        cout << *this << endl;
-    } else {
-        while (step()) {}
+        if (options.detectCycles) {
+            uint64_t hash = hash_.value();
+            pair<uint64_t, size_t>& slot = seen[hash & mask];
+            if (slot.second != NO_STEP && slot.first == hash && sameTapeAt(*start, slot.second)) {
+                result.reason = MarkovHaltReason::Cycle;
+                result.cycleStart = slot.second;
+                break;
+            }
+            slot = make_pair(hash, getCurrentStep());
+        }
+    }
+    hashing_ = false;
+    trace_ = nullptr;
+    if (options.log) {
         cout << *this << endl;
     }
+    result.steps = getCurrentStep();
+    result.tape = getTape();
+    return result;
+}
+
+// Лента на шаге step восстанавливается прогоном копии начальной машины
+bool MarkovMachine::sameTapeAt(const MarkovMachine& start, size_t step) const {
+    MarkovMachine replay(start);
+    while (replay.getCurrentStep() < step && replay.step()) {}
+    return replay.getCurrentStep() == step && replay.otherSymbols_ == otherSymbols_ &&
+           replay.tape_->str() == tape_->str();
 }
 
 void MarkovMachine::loadFromFile(const string& filename) {
@@ -63,8 +300,8 @@ void MarkovMachine::loadFromFile(const string& filename) {
 void MarkovMachine::saveToFile(const string& filename) const {
     ofstream file(filename);
     if (file.is_open()) {
-        file << program_ << endl;
-        file << tape_ << endl;
+        file << getProgram() << endl;
+        file << getTape() << endl;
         file.close();
     }
 }
@@ -75,7 +312,9 @@ ostream& operator<<(ostream& out, const MarkovMachine& machine) {
 }
 
 istream& operator>>(istream& in, MarkovMachine& machine) {
-    in >> machine.program_;
+    MarkovProgram program;
+    in >> program;
+    machine.loadProgram(program);
     
     string line;
     while (getline(in, line)) {
@@ -2,27 +2,113 @@
 #define MARKOVMACHINE_H
 
 #include "MarkovProgram.h"
+#include "MarkovCompiledProgram.h"
+#include "MarkovTape.h"
+#include "MarkovMatchIndex.h"
+#include "MarkovTapeHash.h"
+#include "MarkovTrace.h"
+#ifdef MARKOV_PROFILE
+#include "MarkovProfile.h"
+#endif
 #include <fstream>
+#include <memory>
+#include <chrono>
+#include <cstdint>
 
 using namespace std;
 
+// Scan — каждый шаг проходит автоматом по ленте, начиная рядом с прошлой правкой.
+// Incremental — держит индекс всех вхождений и после шага пересматривает
+// только окно вокруг правки; окупается на длинных прогонах по длинной ленте.
+enum class MarkovSearchMode { Scan, Incremental };
+
+// Почему остановился прогон: сработало заключительное правило, ни одно правило
+// не применимо, исчерпан лимит шагов или времени, лента повторилась
+enum class MarkovHaltReason { FinalRule, NoRule, StepLimit, Deadline, Cycle };
+
+struct MarkovRunResult {
+    string tape;
+    size_t steps;
+    MarkovHaltReason reason;
+    // Для Cycle — шаг, после которого лента впервые была в повторившемся состоянии
+    size_t cycleStart;
+};
+
+struct MarkovRunOptions {
+    size_t maxSteps = SIZE_MAX;
+    // zero — без ограничения по времени; часы проверяются раз в 256 шагов
+    chrono::steady_clock::duration timeout = chrono::steady_clock::duration::zero();
+    // Хеши состояний ленты хранятся в таблице из cycleTableSize ячеек с прямой
+    // адресацией: память ограничена, но цикл длиннее таблицы может быть пропущен.
+    // Совпадение хешей проверяется повторным прогоном от начальной ленты до
+    // найденного шага, так что коллизия хеша не останавливает прогон
+    // (стоит не больше одного лишнего прогона на каждое совпадение)
+    bool detectCycles = false;
+    size_t cycleTableSize = 1 << 16;
+    // Печать ленты после каждого шага; на длинных прогонах дешевле trace
+    bool log = false;
+    // Двоичная трасса шагов прогона; не принадлежит машине, nullptr — без трассы
+    MarkovTrace* trace = nullptr;
+};
+
 class MarkovMachine {
 private:
-    string tape_;
-    MarkovProgram program_;
-    int currentStep_;
+    unique_ptr<MarkovTape> tape_;
+    // В кодировке Utf8 лента хранит коды алфавита программы, а символы вне
+    // алфавита лежат здесь по порядку (см. MarkovAlphabet)
+    string otherSymbols_;
+    // Копия ленты для getTape(), собирается только по запросу
+    mutable string tapeText_;
+    mutable bool tapeTextValid_;
+    // Программа с автоматом; машины, загруженные одной скомпилированной
+    // программой, разделяют ее без копирования
+    shared_ptr<const MarkovCompiledProgram> program_;
+    // Последнее примененное правило и место замены — с него начинается
+    // следующий поиск; NO_RULE, если подсказки нет
+    size_t lastRule_;
+    size_t lastPosition_;
+    MarkovSearchMode searchMode_;
+    MarkovMatchIndex index_;
+    bool indexValid_;
+    // Хеш ленты ведется только во время run с detectCycles
+    MarkovTapeHash hash_;
+    bool hashing_;
+    // Трасса пишется только во время run с trace
+    MarkovTrace* trace_;
+#ifdef MARKOV_PROFILE
+    // Все единицы трансляции должны собираться с одинаковым MARKOV_PROFILE
+    MarkovProfile profile_;
+#endif
+    size_t currentStep_;
+    bool findMatch(MarkovMatch& match);
+    void assignTape(const string& text);
+    bool sameTapeAt(const MarkovMachine& start, size_t step) const;
 
 public:
     MarkovMachine();
+    explicit MarkovMachine(MarkovTapeKind tapeKind, MarkovSearchMode searchMode = MarkovSearchMode::Scan);
+    MarkovMachine(const MarkovMachine& other);
+    MarkovMachine& operator=(const MarkovMachine& other);
 
-    void loadProgram(const MarkovProgram& program);
+    void loadProgram(const MarkovProgram& program, MarkovEncoding encoding = MarkovEncoding::Bytes);
+    void loadProgram(shared_ptr<const MarkovCompiledProgram> program);
     void loadTape(const string& tape);
     const string& getTape() const;
-    int getCurrentStep() const;
+    MarkovTapeKind getTapeKind() const;
+    MarkovSearchMode getSearchMode() const;
+    MarkovEncoding getEncoding() const;
+    size_t getCurrentStep() const;
     const MarkovProgram& getProgram() const;
-    void setCurrentStep(int currentStep);
+    const shared_ptr<const MarkovCompiledProgram>& getCompiledProgram() const;
+    void setCurrentStep(size_t currentStep);
     bool step();  
-    void run(bool log = false);   
+    void run(bool log = false);
+    MarkovRunResult run(const MarkovRunOptions& options);
+#ifdef MARKOV_PROFILE
+    // Счетчики с последней загрузки программы или resetProfile
+    const MarkovProfile& getProfile() const;
+    void resetProfile();
+#endif
     
     void loadFromFile(const string& filename);
     void saveToFile(const string& filename) const;
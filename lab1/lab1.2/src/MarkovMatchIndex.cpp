@@ -0,0 +1,132 @@
+#include "MarkovMatchIndex.h"
+#include <algorithm>
+
+const uint64_t MarkovMatchIndex::TAIL;
+
+#ifdef MARKOV_PROFILE
+MarkovMatchIndex::MarkovMatchIndex() : size_(0), split_(0), scanned_(0) {}
+#else
+MarkovMatchIndex::MarkovMatchIndex() : size_(0), split_(0) {}
+#endif
+
+uint64_t MarkovMatchIndex::keyOf(size_t position) const {
+    return position < split_ ? position : TAIL - (size_ - position);
+}
+
+size_t MarkovMatchIndex::positionOf(uint64_t key) const {
+    return key < split_ ? key : size_ - (TAIL - key);
+}
+
+void MarkovMatchIndex::insert(uint32_t rule, uint64_t key) {
+    if (starts_[rule].empty()) {
+        activeRules_.insert(rule);
+    }
+    starts_[rule].insert(key);
+    byKey_.insert(make_pair(key, rule));
+}
+
+void MarkovMatchIndex::eraseRange(uint64_t first, uint64_t last) {
+    auto begin = byKey_.lower_bound(make_pair(first, uint32_t(0)));
+    auto end = byKey_.lower_bound(make_pair(last, uint32_t(0)));
+    for (auto entry = begin; entry != end; ++entry) {
+        set<uint64_t>& starts = starts_[entry->second];
+        starts.erase(entry->first);
+        if (starts.empty()) {
+            activeRules_.erase(entry->second);
+        }
+    }
+    byKey_.erase(begin, end);
+}
+
+// Вхождения между старой и новой точкой разрыва меняют вид ключа
+void MarkovMatchIndex::moveSplit(size_t position) {
+    uint64_t first = min(keyOf(position), keyOf(split_));
+    uint64_t last = max(keyOf(position), keyOf(split_));
+    vector<pair<size_t, uint32_t>> moved;
+    for (auto entry = byKey_.lower_bound(make_pair(first, uint32_t(0)));
+         entry != byKey_.end() && entry->first < last; ++entry) {
+        moved.push_back(make_pair(positionOf(entry->first), entry->second));
+    }
+    eraseRange(first, last);
+    split_ = position;
+    for (const auto& entry : moved) {
+        insert(entry.second, keyOf(entry.first));
+    }
+}
+
+void MarkovMatchIndex::build(const MarkovMatcher& matcher, const MarkovTape& tape) {
+    clear();
+    starts_.resize(matcher.ruleCount());
+    size_ = tape.size();
+    split_ = size_;
+    vector<MarkovMatch> matches;
+    matcher.findAll(tape, 0, size_, size_, matches);
+#ifdef MARKOV_PROFILE
+    scanned_ += size_;
+#endif
+    for (const MarkovMatch& match : matches) {
+        insert(static_cast<uint32_t>(match.rule), match.position);
+    }
+}
+
+bool MarkovMatchIndex::first(const MarkovMatcher& matcher, MarkovMatch& match) const {
+    size_t emptyRule = matcher.emptyRule();
+    if (!activeRules_.empty() && *activeRules_.begin() < emptyRule) {
+        match.rule = *activeRules_.begin();
+        match.position = positionOf(*starts_[match.rule].begin());
+        return true;
+    }
+    if (emptyRule != MarkovMatcher::NO_RULE) {
+        match.rule = emptyRule;
+        match.position = 0;
+        return true;
+    }
+    return false;
+}
+
+// Вхождения, начатые в [position - maxPatternLength + 1, position + removed),
+// задевали замененные байты и удаляются. Затем окно сканируется заново;
+// вхождения правее position + inserted не менялись и остаются со своими ключами
+void MarkovMatchIndex::update(const MarkovMatcher& matcher, const MarkovTape& tape, size_t position,
+                              size_t removed, size_t inserted) {
+    size_t window = matcher.maxPatternLength();
+    if (window == 0) {
+        size_ = tape.size();
+        split_ = min(split_, size_);
+        return;
+    }
+    size_t from = position + 1 > window ? position + 1 - window : 0;
+    moveSplit(from);
+    eraseRange(keyOf(from), keyOf(position + removed));
+    size_ = size_ - removed + inserted;
+
+    vector<MarkovMatch> matches;
+    size_t to = min(size_, position + inserted + window - 1);
+    matcher.findAll(tape, from, to, position + inserted, matches);
+#ifdef MARKOV_PROFILE
+    scanned_ += to > from ? to - from : 0;
+#endif
+    for (const MarkovMatch& match : matches) {
+        insert(static_cast<uint32_t>(match.rule), keyOf(match.position));
+    }
+}
+
+size_t MarkovMatchIndex::matchCount() const {
+    return byKey_.size();
+}
+
+void MarkovMatchIndex::clear() {
+    starts_.clear();
+    byKey_.clear();
+    activeRules_.clear();
+    size_ = 0;
+    split_ = 0;
+}
+
+#ifdef MARKOV_PROFILE
+size_t MarkovMatchIndex::takeScanned() {
+    size_t scanned = scanned_;
+    scanned_ = 0;
+    return scanned;
+}
+#endif
@@ -0,0 +1,56 @@
+#ifndef MARKOVMATCHINDEX_H
+#define MARKOVMATCHINDEX_H
+
+#include "MarkovMatcher.h"
+#include "MarkovTape.h"
+#include <set>
+#include <vector>
+#include <cstdint>
+
+using namespace std;
+
+// Все текущие вхождения непустых образцов: для каждого правила — упорядоченное
+// множество начал. Замена меняет вхождения только в окне maxPatternLength
+// вокруг правки, поэтому после шага пересматривается только это окно.
+//
+// Позиции хранятся в координатах виртуального разрыва: левее точки разрыва
+// ключ равен позиции, правее — отсчитывается от конца ленты (TAIL - расстояние
+// до конца). Правка в точке разрыва не сдвигает ни одного ключа, а перенос
+// разрыва переписывает только вхождения между старой и новой точкой.
+class MarkovMatchIndex {
+private:
+    static const uint64_t TAIL = uint64_t(1) << 62;
+    vector<set<uint64_t>> starts_;
+    // Те же вхождения по ключу — для переноса разрыва и удаления окна
+    set<pair<uint64_t, uint32_t>> byKey_;
+    set<uint32_t> activeRules_;
+    size_t size_;
+    size_t split_;
+#ifdef MARKOV_PROFILE
+    size_t scanned_;
+#endif
+
+    uint64_t keyOf(size_t position) const;
+    size_t positionOf(uint64_t key) const;
+    void insert(uint32_t rule, uint64_t key);
+    void eraseRange(uint64_t first, uint64_t last);
+    void moveSplit(size_t position);
+
+public:
+    MarkovMatchIndex();
+
+    void build(const MarkovMatcher& matcher, const MarkovTape& tape);
+    // Самое приоритетное правило с вхождением и его самое левое вхождение
+    bool first(const MarkovMatcher& matcher, MarkovMatch& match) const;
+    // Вызывается после замены removed байт на inserted байт в позиции position
+    void update(const MarkovMatcher& matcher, const MarkovTape& tape, size_t position, size_t removed,
+                size_t inserted);
+    size_t matchCount() const;
+    void clear();
+#ifdef MARKOV_PROFILE
+    // Байты, прочитанные build и update с прошлого вызова
+    size_t takeScanned();
+#endif
+};
+
+#endif
@@ -0,0 +1,245 @@
+#include "MarkovMatcher.h"
+#include "MarkovSearch.h"
+#include <algorithm>
+#include <cstring>
+
+const uint32_t MarkovMatcher::NO_RULE;
+
+MarkovMatcher::MarkovMatcher()
+    : classCount_(1), next_(1, 0), minRule_(1, NO_RULE), terminalRule_(1, NO_RULE), outputLink_(1, 0),
+      emptyRule_(NO_RULE), firstRule_(NO_RULE), secondRule_(NO_RULE),
+      maxPatternLength_(0) {
+    memset(classOf_, 0, sizeof(classOf_));
+}
+
+MarkovMatcher::MarkovMatcher(const MarkovProgram& program) : MarkovMatcher() {
+    size_t ruleCount = program.getRuleCount();
+    for (size_t i = 0; i < ruleCount; ++i) {
+        for (unsigned char symbol : program.getRule(i).getPattern()) {
+            if (classOf_[symbol] == 0) {
+                classOf_[symbol] = static_cast<uint8_t>(classCount_++);
+            }
+        }
+    }
+
+    // Бор: 0 в таблице — нет перехода (в корень бор никогда не ведет)
+    next_.assign(classCount_, 0);
+    patternLength_.resize(ruleCount);
+    sameState_.assign(ruleCount, NO_RULE);
+    for (size_t i = 0; i < ruleCount; ++i) {
+        const string& pattern = program.getRule(i).getPattern();
+        uint32_t rule = static_cast<uint32_t>(i);
+        patternLength_[i] = static_cast<uint32_t>(pattern.size());
+        maxPatternLength_ = max(maxPatternLength_, pattern.size());
+        if (pattern.empty()) {
+            emptyRule_ = min(emptyRule_, rule);
+            continue;
+        }
+        firstRule_ = min(firstRule_, rule);
+        uint32_t state = 0;
+        for (unsigned char symbol : pattern) {
+            uint32_t& child = next_[state * classCount_ + classOf_[symbol]];
+            if (child == 0) {
+                child = static_cast<uint32_t>(minRule_.size());
+                minRule_.push_back(NO_RULE);
+                next_.resize(next_.size() + classCount_, 0);
+            }
+            state = next_[state * classCount_ + classOf_[symbol]];
+        }
+        minRule_[state] = min(minRule_[state], rule);
+        terminalRule_.resize(minRule_.size(), NO_RULE);
+        sameState_[i] = terminalRule_[state];
+        terminalRule_[state] = rule;
+    }
+    terminalRule_.resize(minRule_.size(), NO_RULE);
+    outputLink_.assign(minRule_.size(), 0);
+    if (firstRule_ != NO_RULE) {
+        firstPattern_ = program.getRule(firstRule_).getPattern();
+        for (size_t i = firstRule_ + 1; i < ruleCount && secondRule_ == NO_RULE; ++i) {
+            const string& pattern = program.getRule(i).getPattern();
+            if (!pattern.empty() && pattern != firstPattern_) {
+                secondRule_ = static_cast<uint32_t>(i);
+            }
+        }
+    }
+
+    // Обход в ширину достраивает бор до полного автомата: недостающий переход
+    // берется у состояния суффиксной ссылки, которое ближе к корню и уже готово
+    vector<uint32_t> fail(minRule_.size(), 0);
+    vector<uint32_t> queue;
+    queue.reserve(minRule_.size());
+    queue.push_back(0);
+    for (size_t head = 0; head < queue.size(); ++head) {
+        uint32_t state = queue[head];
+        for (size_t symbolClass = 0; symbolClass < classCount_; ++symbolClass) {
+            uint32_t& child = next_[state * classCount_ + symbolClass];
+            uint32_t fallback = state == 0 ? 0 : next_[fail[state] * classCount_ + symbolClass];
+            if (child != 0) {
+                fail[child] = fallback;
+                minRule_[child] = min(minRule_[child], minRule_[fallback]);
+                outputLink_[child] = terminalRule_[fallback] != NO_RULE ? fallback : outputLink_[fallback];
+                queue.push_back(child);
+            } else {
+                child = fallback;
+            }
+        }
+    }
+}
+
+bool MarkovMatcher::find(const string& tape, MarkovMatch& match) const {
+    return find(tape.data(), tape.size(), match);
+}
+
+// Первое вхождение образца — это и самое левое, так как длина образца постоянна.
+// Правило с большим номером, чем уже найденное, ничего не меняет,
+// поэтому на каждый байт достаточно одного сравнения
+bool MarkovMatcher::find(const char* data, size_t length, MarkovMatch& match) const {
+    return find(string_view(data, length), string_view(), 0, NO_RULE, match);
+}
+
+bool MarkovMatcher::find(const MarkovTape& tape, size_t from, size_t ruleLimit, MarkovMatch& match) const {
+    string_view first, second;
+    tape.segments(first, second);
+    return find(first, second, from, ruleLimit, match);
+}
+
+bool MarkovMatcher::find(string_view first, string_view second, size_t from, size_t ruleLimit,
+                         MarkovMatch& match) const {
+    uint32_t best = static_cast<uint32_t>(min<size_t>(ruleLimit, NO_RULE));
+    size_t position = from;
+#ifdef MARKOV_PROFILE
+    size_t start = from;
+    size_t end = from;
+#endif
+    if (emptyRule_ < best) {
+        best = emptyRule_;
+    }
+    if (firstRule_ < best && secondRule_ >= best) {
+        size_t found = findFirstPattern(first, second, from);
+        if (found != string_view::npos) {
+            best = firstRule_;
+            position = found;
+        }
+#ifdef MARKOV_PROFILE
+        end = found != string_view::npos ? found + firstPattern_.size() : max(start, first.size() + second.size());
+#endif
+    } else if (firstRule_ < best) {
+        uint32_t state = 0;
+        bool stopped = false;
+        if (from < first.size()) {
+            stopped = scan(first.substr(from), from, state, best, position);
+            from = first.size();
+        }
+        if (!stopped) {
+            stopped = scan(second.substr(min(from - first.size(), second.size())), from, state, best, position);
+        }
+#ifdef MARKOV_PROFILE
+        end = stopped ? position + patternLength_[best] : max(start, first.size() + second.size());
+#endif
+    }
+#ifdef MARKOV_PROFILE
+    match.scanned = end - start;
+#endif
+    if (best >= ruleLimit || best == NO_RULE) {
+        return false;
+    }
+    match.rule = best;
+    match.position = position;
+    return true;
+}
+
+// Самое левое вхождение firstPattern_ не раньше from в тексте из двух кусков
+size_t MarkovMatcher::findFirstPattern(string_view first, string_view second, size_t from) const {
+    size_t length = firstPattern_.size();
+    if (from < first.size()) {
+        size_t found = markovFind(first.substr(from), firstPattern_);
+        if (found != string_view::npos) {
+            return from + found;
+        }
+    }
+    // Вхождения, начатые в первом куске и законченные во втором
+    size_t seamStart = max(from, first.size() + 1 > length ? first.size() + 1 - length : 0);
+    if (seamStart < first.size() && !second.empty()) {
+        string seam(first.substr(seamStart));
+        seam.append(second.substr(0, length - 1));
+        size_t found = markovFind(seam, firstPattern_);
+        if (found != string_view::npos) {
+            return seamStart + found;
+        }
+    }
+    size_t secondFrom = max(from, first.size()) - first.size();
+    if (secondFrom <= second.size()) {
+        size_t found = markovFind(second.substr(secondFrom), firstPattern_);
+        if (found != string_view::npos) {
+            return first.size() + secondFrom + found;
+        }
+    }
+    return string_view::npos;
+}
+
+// Первое вхождение образца — это и самое левое, так как длина образца постоянна.
+// Правило с большим номером, чем уже найденное, ничего не меняет,
+// поэтому на каждый байт достаточно одного сравнения
+bool MarkovMatcher::scan(string_view text, size_t offset, uint32_t& state, uint32_t& best, size_t& position) const {
+    const uint32_t* next = next_.data();
+    const uint32_t* minRule = minRule_.data();
+    size_t classCount = classCount_;
+    for (size_t i = 0; i < text.size(); ++i) {
+        state = next[state * classCount + classOf_[static_cast<unsigned char>(text[i])]];
+        uint32_t rule = minRule[state];
+        if (rule < best) {
+            best = rule;
+            position = offset + i + 1 - patternLength_[rule];
+            if (best == firstRule_) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+void MarkovMatcher::findAll(const MarkovTape& tape, size_t from, size_t to, size_t startLimit,
+                            vector<MarkovMatch>& matches) const {
+    string_view first, second;
+    tape.segments(first, second);
+    uint32_t state = 0;
+    for (size_t i = from; i < to; ++i) {
+        char symbol = i < first.size() ? first[i] : second[i - first.size()];
+        state = next_[state * classCount_ + classOf_[static_cast<unsigned char>(symbol)]];
+        if (minRule_[state] == NO_RULE) {
+            continue;
+        }
+        for (uint32_t output = terminalRule_[state] != NO_RULE ? state : outputLink_[state]; output != 0;
+             output = outputLink_[output]) {
+            for (uint32_t rule = terminalRule_[output]; rule != NO_RULE; rule = sameState_[rule]) {
+                size_t start = i + 1 - patternLength_[rule];
+                if (start < startLimit) {
+                    MarkovMatch match = MarkovMatch();
+                    match.rule = rule;
+                    match.position = start;
+                    matches.push_back(match);
+                }
+            }
+        }
+    }
+}
+
+size_t MarkovMatcher::ruleCount() const {
+    return patternLength_.size();
+}
+
+size_t MarkovMatcher::stateCount() const {
+    return minRule_.size();
+}
+
+size_t MarkovMatcher::maxPatternLength() const {
+    return maxPatternLength_;
+}
+
+size_t MarkovMatcher::patternLength(size_t rule) const {
+    return patternLength_[rule];
+}
+
+size_t MarkovMatcher::emptyRule() const {
+    return emptyRule_;
+}
@@ -0,0 +1,73 @@
+#ifndef MARKOVMATCHER_H
+#define MARKOVMATCHER_H
+
+#include "MarkovProgram.h"
+#include "MarkovTape.h"
+#include <cstdint>
+#include <vector>
+
+using namespace std;
+
+struct MarkovMatch {
+    size_t rule;
+    size_t position;
+#ifdef MARKOV_PROFILE
+    // Сколько байт прочитал find, в том числе если вхождения нет
+    size_t scanned = 0;
+#endif
+};
+
+// Программа, скомпилированная в автомат Ахо-Корасик по всем образцам.
+// За один проход по ленте находит правило с наименьшим номером, у которого
+// есть вхождение, и самое левое вхождение этого правила — ровно то, что
+// выбирает перебор правил по порядку с string::find.
+// Байты, которых нет ни в одном образце, сливаются в один класс, поэтому
+// таблица переходов занимает состояния × (различные байты образцов + 1).
+class MarkovMatcher {
+public:
+    static const uint32_t NO_RULE = UINT32_MAX;
+
+private:
+    uint8_t classOf_[256];
+    size_t classCount_;
+    vector<uint32_t> next_;
+    // Наименьший номер правила среди образцов, оканчивающихся в состоянии
+    vector<uint32_t> minRule_;
+    vector<uint32_t> patternLength_;
+    // Для перечисления всех вхождений: правила, образец которых равен строке
+    // состояния (список через sameState_), и ближайший суффикс с таким правилом
+    vector<uint32_t> terminalRule_;
+    vector<uint32_t> sameState_;
+    vector<uint32_t> outputLink_;
+    uint32_t emptyRule_;
+    uint32_t firstRule_;
+    // Если правил с номером меньше secondRule_ и другим образцом нет, ответ —
+    // первое вхождение firstPattern_, и его ищет векторный markovFind
+    uint32_t secondRule_;
+    string firstPattern_;
+    size_t maxPatternLength_;
+    bool scan(string_view text, size_t offset, uint32_t& state, uint32_t& best, size_t& position) const;
+    size_t findFirstPattern(string_view first, string_view second, size_t from) const;
+
+public:
+    MarkovMatcher();
+    explicit MarkovMatcher(const MarkovProgram& program);
+
+    bool find(const string& tape, MarkovMatch& match) const;
+    bool find(const char* data, size_t length, MarkovMatch& match) const;
+    // Поиск только среди правил с номером меньше ruleLimit и только вхождений,
+    // начинающихся не раньше from. Текст может быть разбит на два куска
+    bool find(string_view first, string_view second, size_t from, size_t ruleLimit, MarkovMatch& match) const;
+    bool find(const MarkovTape& tape, size_t from, size_t ruleLimit, MarkovMatch& match) const;
+    // Все вхождения непустых образцов внутри [from, to), начинающиеся раньше startLimit
+    void findAll(const MarkovTape& tape, size_t from, size_t to, size_t startLimit, vector<MarkovMatch>& matches) const;
+
+    size_t ruleCount() const;
+    size_t stateCount() const;
+    size_t maxPatternLength() const;
+    size_t patternLength(size_t rule) const;
+    // Наименьший номер правила с пустым образцом или NO_RULE
+    size_t emptyRule() const;
+};
+
+#endif
@@ -0,0 +1,89 @@
+#include "MarkovProfile.h"
+#include <cstdio>
+
+namespace {
+
+string csvField(const string& text) {
+    string quoted = "\"";
+    for (char symbol : text) {
+        if (symbol == '"') {
+            quoted += '"';
+        }
+        quoted += symbol;
+    }
+    return quoted + "\"";
+}
+
+string jsonString(const string& text) {
+    string quoted = "\"";
+    for (unsigned char symbol : text) {
+        if (symbol == '"' || symbol == '\\') {
+            quoted += '\\';
+            quoted += static_cast<char>(symbol);
+        } else if (symbol < 0x20) {
+            char escaped[8];
+            snprintf(escaped, sizeof(escaped), "\\u%04x", symbol);
+            quoted += escaped;
+        } else {
+            quoted += static_cast<char>(symbol);
+        }
+    }
+    return quoted + "\"";
+}
+
+}
+
+MarkovProfile::MarkovProfile() : steps_(0), failedSteps_(0), failedBytesScanned_(0) {}
+
+void MarkovProfile::reset(size_t ruleCount) {
+    stoppedAt_.assign(ruleCount, 0);
+    bytesScanned_.assign(ruleCount, 0);
+    bytesRewritten_.assign(ruleCount, 0);
+    steps_ = 0;
+    failedSteps_ = 0;
+    failedBytesScanned_ = 0;
+}
+
+size_t MarkovProfile::ruleCount() const {
+    return stoppedAt_.size();
+}
+
+uint64_t MarkovProfile::steps() const {
+    return steps_;
+}
+
+vector<MarkovRuleCounters> MarkovProfile::counters() const {
+    vector<MarkovRuleCounters> result(ruleCount());
+    uint64_t tried = failedSteps_;
+    for (size_t i = ruleCount(); i-- > 0;) {
+        tried += stoppedAt_[i];
+        result[i] = MarkovRuleCounters{tried, stoppedAt_[i], bytesScanned_[i], bytesRewritten_[i]};
+    }
+    return result;
+}
+
+void MarkovProfile::writeCsv(ostream& out, const MarkovProgram& program) const {
+    vector<MarkovRuleCounters> rules = counters();
+    out << "rule,pattern,replacement,final,tried,matched,bytes_scanned,bytes_rewritten\n";
+    for (size_t i = 0; i < rules.size() && i < static_cast<size_t>(program.getRuleCount()); ++i) {
+        const MarkovRule& rule = program.getRule(i);
+        out << i << ',' << csvField(rule.getPattern()) << ',' << csvField(rule.getReplacement()) << ','
+            << (rule.getIsFinal() ? 1 : 0) << ',' << rules[i].tried << ',' << rules[i].matched << ','
+            << rules[i].bytesScanned << ',' << rules[i].bytesRewritten << '\n';
+    }
+}
+
+void MarkovProfile::writeJson(ostream& out, const MarkovProgram& program) const {
+    vector<MarkovRuleCounters> rules = counters();
+    out << "{\"steps\":" << steps_ << ",\"unmatched_steps\":" << failedSteps_
+        << ",\"unmatched_bytes_scanned\":" << failedBytesScanned_ << ",\"rules\":[";
+    for (size_t i = 0; i < rules.size() && i < static_cast<size_t>(program.getRuleCount()); ++i) {
+        const MarkovRule& rule = program.getRule(i);
+        out << (i ? "," : "") << "{\"rule\":" << i << ",\"pattern\":" << jsonString(rule.getPattern())
+            << ",\"replacement\":" << jsonString(rule.getReplacement())
+            << ",\"final\":" << (rule.getIsFinal() ? "true" : "false") << ",\"tried\":" << rules[i].tried
+            << ",\"matched\":" << rules[i].matched << ",\"bytes_scanned\":" << rules[i].bytesScanned
+            << ",\"bytes_rewritten\":" << rules[i].bytesRewritten << "}";
+    }
+    out << "]}\n";
+}
@@ -0,0 +1,59 @@
+#ifndef MARKOVPROFILE_H
+#define MARKOVPROFILE_H
+
+#include "MarkovProgram.h"
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+using namespace std;
+
+struct MarkovRuleCounters {
+    // Сколько шагов правило проверялось: при переборе по порядку это все шаги,
+    // на которых не сработало ни одно правило с меньшим номером
+    uint64_t tried;
+    uint64_t matched;
+    // Байты, прочитанные поиском на шагах, где было применено это правило
+    uint64_t bytesScanned;
+    // Байты, записанные заменой (длина правой части)
+    uint64_t bytesRewritten;
+};
+
+// Счетчики по правилам. Машина ведет их только в сборке с MARKOV_PROFILE
+// (make profile); без флага в MarkovMachine нет ни полей, ни кода профиля.
+class MarkovProfile {
+private:
+    // Шаги, закончившиеся на правиле r; tried(i) — сумма по r >= i плюс шаги без правила
+    vector<uint64_t> stoppedAt_;
+    vector<uint64_t> bytesScanned_;
+    vector<uint64_t> bytesRewritten_;
+    uint64_t steps_;
+    uint64_t failedSteps_;
+    uint64_t failedBytesScanned_;
+
+public:
+    MarkovProfile();
+
+    void reset(size_t ruleCount);
+    void recordMatch(size_t rule, size_t bytesScanned, size_t bytesRewritten) {
+        ++steps_;
+        ++stoppedAt_[rule];
+        bytesScanned_[rule] += bytesScanned;
+        bytesRewritten_[rule] += bytesRewritten;
+    }
+    void recordNoMatch(size_t bytesScanned) {
+        ++steps_;
+        ++failedSteps_;
+        failedBytesScanned_ += bytesScanned;
+    }
+
+    size_t ruleCount() const;
+    uint64_t steps() const;
+    vector<MarkovRuleCounters> counters() const;
+
+    // Столбцы: rule, pattern, replacement, final, tried, matched, bytes_scanned, bytes_rewritten
+    void writeCsv(ostream& out, const MarkovProgram& program) const;
+    void writeJson(ostream& out, const MarkovProgram& program) const;
+};
+
+#endif
@@ -1,28 +1,129 @@
 #include "MarkovProgram.h"
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <functional>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
-void MarkovProgram::addRule(const MarkovRule& rule) {
-    for (const auto& currentRule : rules_) {
-        if (currentRule == rule) {
-            return;
+namespace {
+
+size_t ruleHash(string_view pattern, string_view replacement) {
+    size_t hash = std::hash<string_view>()(pattern);
+    return hash ^ (std::hash<string_view>()(replacement) + 0x9e3779b97f4a7c15ULL + (hash << 6) + (hash >> 2));
+}
+
+// Файл целиком, отображенный только для чтения
+class MappedFile {
+private:
+    const char* data_;
+    size_t length_;
+
+public:
+    MappedFile() : data_(nullptr), length_(0) {}
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    ~MappedFile() {
+        if (data_) {
+            munmap(const_cast<char*>(data_), length_);
+        }
+    }
+
+    bool open(const string& filename) {
+        int fd = ::open(filename.c_str(), O_RDONLY);
+        if (fd < 0) {
+            return false;
+        }
+        struct stat info;
+        if (fstat(fd, &info) != 0) {
+            ::close(fd);
+            return false;
+        }
+        length_ = static_cast<size_t>(info.st_size);
+        if (length_ == 0) {
+            ::close(fd);
+            return true;
+        }
+        void* mapped = mmap(nullptr, length_, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (mapped == MAP_FAILED) {
+            length_ = 0;
+            return false;
+        }
+        madvise(mapped, length_, MADV_SEQUENTIAL);
+        data_ = static_cast<const char*>(mapped);
+        return true;
+    }
+
+    string_view view() const {
+        return string_view(data_, length_);
+    }
+};
+
+}
+
+size_t MarkovProgram::findSlot(string_view pattern, string_view replacement) const {
+    size_t mask = slots_.size() - 1;
+    size_t slot = ruleHash(pattern, replacement) & mask;
+    while (slots_[slot] != 0) {
+        const MarkovRule& rule = rules_[slots_[slot] - 1];
+        if (rule.getPattern() == pattern && rule.getReplacement() == replacement) {
+            break;
         }
+        slot = (slot + 1) & mask;
     }
-    rules_.push_back(rule);
+    return slot;
+}
+
+void MarkovProgram::rebuildIndex(size_t capacity) {
+    size_t size = 16;
+    while (size < 2 * capacity) {
+        size <<= 1;
+    }
+    slots_.assign(size, 0);
+    for (size_t i = 0; i < rules_.size(); ++i) {
+        size_t slot = findSlot(rules_[i].getPattern(), rules_[i].getReplacement());
+        if (slots_[slot] == 0) {
+            slots_[slot] = static_cast<uint32_t>(i + 1);
+        }
+    }
+}
+
+void MarkovProgram::appendRule(string_view pattern, string_view replacement, bool isFinal) {
+    if (2 * (rules_.size() + 1) > slots_.size()) {
+        rebuildIndex(2 * rules_.size() + 1);
+    }
+    size_t slot = findSlot(pattern, replacement);
+    if (slots_[slot] != 0) {
+        return;
+    }
+    rules_.emplace_back("", "");
+    rules_.back().assign(pattern, replacement, isFinal);
+    slots_[slot] = static_cast<uint32_t>(rules_.size());
+}
+
+void MarkovProgram::addRule(const MarkovRule& rule) {
+    appendRule(rule.getPattern(), rule.getReplacement(), rule.getIsFinal());
 }
 
 void MarkovProgram::removeRule(size_t index) {
     if (index < getRuleCount()) {
         rules_.erase(rules_.begin() + index);
+        rebuildIndex(rules_.size());
     }
 }
 
 bool MarkovProgram::removeRule(const string& pattern, const string& replacement) {
-    for (auto rule = rules_.begin(); rule != rules_.end(); ++rule) {
-        if (rule->getPattern() == pattern && rule->getReplacement() == replacement) {
-            rules_.erase(rule);
-            return true;
-        }
+    if (rules_.empty()) {
+        return false;
+    }
+    uint32_t found = slots_[findSlot(pattern, replacement)];
+    if (found == 0) {
+        return false;
     }
-    return false;
+    removeRule(found - 1);
+    return true;
 }
 
 const MarkovRule& MarkovProgram::getRule(size_t index) const {
@@ -38,24 +139,141 @@ bool MarkovProgram::modifyRule(size_t index, const string& pattern, const string
         return false;
     }
     rules_[index] = MarkovRule(pattern, result, isFinal);
+    rebuildIndex(rules_.size());
     return true;
 }
 
+// Строки до первой пустой, как у operator>>; строка без "->" дает пустое правило
+bool MarkovProgram::parseText(string_view text) {
+    size_t lines = 0;
+    for (char symbol : text) {
+        lines += symbol == '\n';
+    }
+    rules_.reserve(lines + 1);
+    rebuildIndex(lines + 1);
+
+    MarkovRule rule("", "");
+    size_t begin = 0;
+    while (begin < text.size()) {
+        size_t end = text.find('\n', begin);
+        if (end == string_view::npos) {
+            end = text.size();
+        }
+        string_view line = text.substr(begin, end - begin);
+        if (line.empty()) {
+            break;
+        }
+        if (MarkovRule::parse(line, rule)) {
+            appendRule(rule.getPattern(), rule.getReplacement(), rule.getIsFinal());
+        } else {
+            appendRule(string_view(), string_view(), false);
+        }
+        begin = end + 1;
+    }
+    return true;
+}
+
+bool MarkovProgram::parseBinary(string_view data) {
+    MarkovProgramFileHeader header;
+    if (data.size() < sizeof(header)) {
+        return false;
+    }
+    memcpy(&header, data.data(), sizeof(header));
+    size_t tableEnd = sizeof(header);
+    if (memcmp(header.magic, MARKOV_PROGRAM_FILE_MAGIC, sizeof(header.magic)) != 0 ||
+        header.version != MARKOV_PROGRAM_FILE_VERSION ||
+        header.count > (data.size() - tableEnd) / sizeof(MarkovProgramFileEntry)) {
+        return false;
+    }
+    tableEnd += header.count * sizeof(MarkovProgramFileEntry);
+    string_view strings = data.substr(tableEnd);
+    rules_.reserve(header.count);
+    rebuildIndex(header.count);
+    for (uint64_t i = 0; i < header.count; ++i) {
+        MarkovProgramFileEntry entry;
+        memcpy(&entry, data.data() + sizeof(header) + i * sizeof(entry), sizeof(entry));
+        if (uint64_t(entry.patternOffset) + entry.patternLength > strings.size() ||
+            uint64_t(entry.replacementOffset) + entry.replacementLength > strings.size()) {
+            return false;
+        }
+        appendRule(strings.substr(entry.patternOffset, entry.patternLength),
+                   strings.substr(entry.replacementOffset, entry.replacementLength), entry.isFinal != 0);
+    }
+    return true;
+}
+
+bool MarkovProgram::loadFromFile(const string& filename) {
+    MappedFile file;
+    if (!file.open(filename)) {
+        return false;
+    }
+    string_view data = file.view();
+    MarkovProgram loaded;
+    bool binary = data.size() >= sizeof(MARKOV_PROGRAM_FILE_MAGIC) &&
+                  memcmp(data.data(), MARKOV_PROGRAM_FILE_MAGIC, sizeof(MARKOV_PROGRAM_FILE_MAGIC)) == 0;
+    if (!(binary ? loaded.parseBinary(data) : loaded.parseText(data))) {
+        return false;
+    }
+    *this = std::move(loaded);
+    return true;
+}
+
+bool MarkovProgram::saveToFile(const string& filename, MarkovProgramFormat format) const {
+    ofstream file(filename, ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+    if (format == MarkovProgramFormat::Text) {
+        file << *this;
+        return static_cast<bool>(file);
+    }
+
+    MarkovProgramFileHeader header;
+    memcpy(header.magic, MARKOV_PROGRAM_FILE_MAGIC, sizeof(header.magic));
+    header.version = MARKOV_PROGRAM_FILE_VERSION;
+    header.count = rules_.size();
+    vector<MarkovProgramFileEntry> entries(rules_.size());
+    uint64_t offset = 0;
+    for (size_t i = 0; i < rules_.size(); ++i) {
+        const MarkovRule& rule = rules_[i];
+        if (offset + rule.getPattern().size() + rule.getReplacement().size() > UINT32_MAX) {
+            return false;
+        }
+        entries[i].patternOffset = static_cast<uint32_t>(offset);
+        entries[i].patternLength = static_cast<uint32_t>(rule.getPattern().size());
+        offset += rule.getPattern().size();
+        entries[i].replacementOffset = static_cast<uint32_t>(offset);
+        entries[i].replacementLength = static_cast<uint32_t>(rule.getReplacement().size());
+        offset += rule.getReplacement().size();
+        entries[i].isFinal = rule.getIsFinal() ? 1 : 0;
+    }
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(entries.data()), entries.size() * sizeof(MarkovProgramFileEntry));
+    for (const MarkovRule& rule : rules_) {
+        file << rule.getPattern() << rule.getReplacement();
+    }
+    return static_cast<bool>(file);
+}
+
 ostream& operator<<(ostream& out, const MarkovProgram& program) {
     for (size_t i = 0; i < program.getRuleCount(); ++i) {
-        out << program.rules_[i] << endl;
+        out << program.rules_[i] << '\n';
     }
     return out;
 }
 
 istream& operator>>(istream& in, MarkovProgram& program) {
-    program.rules_.clear(); 
-    
-    string line;    
+    program.rules_.clear();
+    program.slots_.clear();
+
+    string line;
+    MarkovRule rule("", "");
     while (getline(in, line) && !line.empty()) {
-        MarkovRule rule("", "");
-        istringstream(line) >> rule;
-        program.addRule(rule);
+        if (MarkovRule::parse(line, rule)) {
+            program.appendRule(rule.getPattern(), rule.getReplacement(), rule.getIsFinal());
+        } else {
+            program.appendRule(string_view(), string_view(), false);
+        }
     }
     return in;
 }
@@ -3,11 +3,42 @@
 #include "MarkovRule.h"
 #include <vector>
 #include <sstream>
+#include <cstdint>
+#include <string_view>
 using namespace std;
 
+enum class MarkovProgramFormat { Text, Binary };
+
+// Двоичный формат: заголовок, таблица правил, затем все строки подряд
+struct MarkovProgramFileHeader {
+    char magic[4];
+    uint32_t version;
+    uint64_t count;
+};
+
+struct MarkovProgramFileEntry {
+    uint32_t patternOffset;
+    uint32_t patternLength;
+    uint32_t replacementOffset;
+    uint32_t replacementLength;
+    uint32_t isFinal;
+};
+
+const char MARKOV_PROGRAM_FILE_MAGIC[4] = {'M', 'K', 'P', 'G'};
+const uint32_t MARKOV_PROGRAM_FILE_VERSION = 1;
+
 class MarkovProgram {
 private:
     vector<MarkovRule> rules_;
+    // Хеш-индекс правил для поиска дубликатов: открытая адресация,
+    // в ячейке номер правила + 1, 0 — свободно. Заполнен не больше чем наполовину
+    vector<uint32_t> slots_;
+
+    size_t findSlot(string_view pattern, string_view replacement) const;
+    void rebuildIndex(size_t capacity);
+    void appendRule(string_view pattern, string_view replacement, bool isFinal);
+    bool parseText(string_view text);
+    bool parseBinary(string_view data);
 
 public:
     void addRule(const MarkovRule& rule);
@@ -16,8 +47,14 @@ public:
     const MarkovRule& getRule(size_t index) const;
     int getRuleCount() const;
     bool modifyRule(size_t index, const string& pattern, const string& result, bool isFinal);
+
+    // Формат определяется по сигнатуре; файл отображается в память и
+    // разбирается за один проход. При ошибке программа не меняется
+    bool loadFromFile(const string& filename);
+    bool saveToFile(const string& filename, MarkovProgramFormat format = MarkovProgramFormat::Text) const;
+
     friend ostream& operator<<(ostream& out, const MarkovProgram& program);
     friend istream& operator>>(istream& in, MarkovProgram& program);
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -38,28 +38,43 @@ ostream& operator<<(ostream& out, const MarkovRule& rule) {
     return out;
 }
 
+namespace {
+
+string_view trimmed(string_view text) {
+    size_t first = text.find_first_not_of(" \t");
+    if (first == string_view::npos) {
+        return string_view();
+    }
+    return text.substr(first, text.find_last_not_of(" \t") + 1 - first);
+}
+
+}
+
+void MarkovRule::assign(string_view pattern, string_view replacement, bool isFinal) {
+    pattern_.assign(pattern.data(), pattern.size());
+    replacement_.assign(replacement.data(), replacement.size());
+    isFinal_ = isFinal;
+}
+
+bool MarkovRule::parse(string_view line, MarkovRule& rule) {
+    size_t arrowPos = line.find("->");
+    if (arrowPos == string_view::npos) {
+        return false;
+    }
+    string_view replacementPart = line.substr(arrowPos + 2);
+    size_t finalPos = replacementPart.find("[FINAL]");
+    bool isFinal = finalPos != string_view::npos;
+    if (isFinal) {
+        replacementPart = replacementPart.substr(0, finalPos);
+    }
+    rule.assign(trimmed(line.substr(0, arrowPos)), trimmed(replacementPart), isFinal);
+    return true;
+}
+
 istream& operator>>(istream& in, MarkovRule& rule) {
     string line;
     if (getline(in, line)) {
-        size_t arrowPos = line.find("->");
-        if (arrowPos != string::npos) {
-            rule.setPattern(line.substr(0, arrowPos));
-            rule.pattern_.erase(0, rule.pattern_.find_first_not_of(" \t"));
-            rule.pattern_.erase(rule.pattern_.find_last_not_of(" \t") + 1);
-            
-            string replacementPart = line.substr(arrowPos + 2);
-            size_t finalPos = replacementPart.find("[FINAL]");
-            if (finalPos != string::npos) {
-                rule.setIsFinal(true);
-                replacementPart = replacementPart.substr(0, finalPos);
-            } else {
-                rule.setIsFinal(false);
-            }
-            
-            replacementPart.erase(0, replacementPart.find_first_not_of(" \t"));
-            replacementPart.erase(replacementPart.find_last_not_of(" \t") + 1);
-            rule.setReplacement(replacementPart);
-        }
+        MarkovRule::parse(line, rule);
     }
     return in;
-}
\ No newline at end of file
+}
@@ -2,6 +2,7 @@
 #define MARKOVRULE_H
 
 #include <string>
+#include <string_view>
 #include <iostream>
 
 
@@ -23,6 +24,11 @@ public:
     void setPattern(const string& pattern);
     void setReplacement(const string& replacement);
     void setIsFinal(bool isFinal);
+    void assign(string_view pattern, string_view replacement, bool isFinal);
+
+    // Разбор строки "образец -> замена [FINAL]" без промежуточных копий;
+    // false и правило без изменений, если в строке нет "->"
+    static bool parse(string_view line, MarkovRule& rule);
 
     bool operator==(const MarkovRule& otherRule) const;
     friend ostream& operator<<(ostream& out, const MarkovRule& rule);
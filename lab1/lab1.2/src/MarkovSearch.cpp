@@ -0,0 +1,152 @@
+#include "MarkovSearch.h"
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define MARKOV_SEARCH_X86 1
+#endif
+
+namespace {
+
+typedef size_t (*FindFunction)(const char* text, size_t length, const char* pattern, size_t patternLength);
+
+// Кандидат i: text[i] и text[i + last] совпали, сравнить середину
+inline bool matchesAt(const char* text, size_t i, const char* pattern, size_t patternLength) {
+    return patternLength <= 2 || memcmp(text + i + 1, pattern + 1, patternLength - 2) == 0;
+}
+
+size_t findScalarFrom(const char* text, size_t length, const char* pattern, size_t patternLength, size_t from) {
+    size_t last = patternLength - 1;
+    for (size_t i = from; i + last < length; ++i) {
+        if (text[i] == pattern[0] && text[i + last] == pattern[last] && matchesAt(text, i, pattern, patternLength)) {
+            return i;
+        }
+    }
+    return string_view::npos;
+}
+
+size_t findScalar(const char* text, size_t length, const char* pattern, size_t patternLength) {
+    return findScalarFrom(text, length, pattern, patternLength, 0);
+}
+
+#ifdef MARKOV_SEARCH_X86
+
+__attribute__((target("sse2")))
+size_t findSSE2(const char* text, size_t length, const char* pattern, size_t patternLength) {
+    size_t last = patternLength - 1;
+    const __m128i first = _mm_set1_epi8(pattern[0]);
+    const __m128i final = _mm_set1_epi8(pattern[last]);
+    size_t i = 0;
+    for (; i + last + 16 <= length; i += 16) {
+        __m128i head = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text + i));
+        __m128i tail = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text + i + last));
+        unsigned mask = static_cast<unsigned>(
+            _mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(head, first), _mm_cmpeq_epi8(tail, final))));
+        while (mask != 0) {
+            size_t candidate = i + __builtin_ctz(mask);
+            if (matchesAt(text, candidate, pattern, patternLength)) {
+                return candidate;
+            }
+            mask &= mask - 1;
+        }
+    }
+    return findScalarFrom(text, length, pattern, patternLength, i);
+}
+
+__attribute__((target("avx2")))
+size_t findAVX2(const char* text, size_t length, const char* pattern, size_t patternLength) {
+    size_t last = patternLength - 1;
+    const __m256i first = _mm256_set1_epi8(pattern[0]);
+    const __m256i final = _mm256_set1_epi8(pattern[last]);
+    size_t i = 0;
+    for (; i + last + 32 <= length; i += 32) {
+        __m256i head = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(text + i));
+        __m256i tail = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(text + i + last));
+        unsigned mask = static_cast<unsigned>(
+            _mm256_movemask_epi8(_mm256_and_si256(_mm256_cmpeq_epi8(head, first), _mm256_cmpeq_epi8(tail, final))));
+        while (mask != 0) {
+            size_t candidate = i + __builtin_ctz(mask);
+            if (matchesAt(text, candidate, pattern, patternLength)) {
+                return candidate;
+            }
+            mask &= mask - 1;
+        }
+    }
+    return findScalarFrom(text, length, pattern, patternLength, i);
+}
+
+#endif
+
+FindFunction functionOf(MarkovSearchKernel kernel) {
+#ifdef MARKOV_SEARCH_X86
+    if (kernel == MarkovSearchKernel::AVX2) {
+        return findAVX2;
+    }
+    if (kernel == MarkovSearchKernel::SSE2) {
+        return findSSE2;
+    }
+#else
+    (void)kernel;
+#endif
+    return findScalar;
+}
+
+MarkovSearchKernel detectKernel() {
+#ifdef MARKOV_SEARCH_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return MarkovSearchKernel::AVX2;
+    }
+    if (__builtin_cpu_supports("sse2")) {
+        return MarkovSearchKernel::SSE2;
+    }
+#endif
+    return MarkovSearchKernel::Scalar;
+}
+
+// Выбор делается один раз, дальше вызов по готовому указателю
+FindFunction selectedFunction() {
+    static const FindFunction function = functionOf(markovSearchKernel());
+    return function;
+}
+
+size_t find(FindFunction function, string_view text, string_view pattern) {
+    if (pattern.empty()) {
+        return 0;
+    }
+    if (pattern.size() > text.size()) {
+        return string_view::npos;
+    }
+    // Для одного байта memchr из libc уже векторный
+    if (pattern.size() == 1 && function != findScalar) {
+        const void* found = memchr(text.data(), pattern[0], text.size());
+        return found ? static_cast<const char*>(found) - text.data() : string_view::npos;
+    }
+    return function(text.data(), text.size(), pattern.data(), pattern.size());
+}
+
+}
+
+MarkovSearchKernel markovSearchKernel() {
+    static const MarkovSearchKernel kernel = detectKernel();
+    return kernel;
+}
+
+bool markovSearchKernelSupported(MarkovSearchKernel kernel) {
+    switch (kernel) {
+    case MarkovSearchKernel::AVX2:
+        return markovSearchKernel() == MarkovSearchKernel::AVX2;
+    case MarkovSearchKernel::SSE2:
+        return markovSearchKernel() != MarkovSearchKernel::Scalar;
+    default:
+        return true;
+    }
+}
+
+size_t markovFind(string_view text, string_view pattern) {
+    return find(selectedFunction(), text, pattern);
+}
+
+size_t markovFind(MarkovSearchKernel kernel, string_view text, string_view pattern) {
+    return find(functionOf(markovSearchKernelSupported(kernel) ? kernel : MarkovSearchKernel::Scalar), text, pattern);
+}
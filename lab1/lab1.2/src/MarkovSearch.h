@@ -0,0 +1,22 @@
+#ifndef MARKOVSEARCH_H
+#define MARKOVSEARCH_H
+
+#include <string>
+#include <string_view>
+
+using namespace std;
+
+// Поиск одного образца: векторное сравнение первого и последнего байта
+// образца сразу с 16 (SSE2) или 32 (AVX2) позициями текста, середина
+// проверяется только у кандидатов. Набор команд выбирается при первом вызове
+// по возможностям процессора; на других архитектурах — скалярный вариант.
+enum class MarkovSearchKernel { Scalar, SSE2, AVX2 };
+
+// Позиция первого вхождения pattern в text или string_view::npos
+size_t markovFind(string_view text, string_view pattern);
+size_t markovFind(MarkovSearchKernel kernel, string_view text, string_view pattern);
+
+MarkovSearchKernel markovSearchKernel();
+bool markovSearchKernelSupported(MarkovSearchKernel kernel);
+
+#endif
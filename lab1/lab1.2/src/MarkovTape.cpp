@@ -0,0 +1,107 @@
+#include "MarkovTape.h"
+#include <algorithm>
+#include <cstring>
+
+unique_ptr<MarkovTape> MarkovTape::create(MarkovTapeKind kind) {
+    if (kind == MarkovTapeKind::String) {
+        return make_unique<StringTape>();
+    }
+    return make_unique<GapBufferTape>();
+}
+
+string MarkovTape::str() const {
+    string_view first, second;
+    segments(first, second);
+    string text;
+    text.reserve(first.size() + second.size());
+    text.append(first);
+    text.append(second);
+    return text;
+}
+
+unique_ptr<MarkovTape> StringTape::clone() const {
+    return make_unique<StringTape>(*this);
+}
+
+MarkovTapeKind StringTape::kind() const {
+    return MarkovTapeKind::String;
+}
+
+void StringTape::assign(const string& text) {
+    text_ = text;
+}
+
+size_t StringTape::size() const {
+    return text_.size();
+}
+
+void StringTape::replace(size_t position, size_t length, string_view replacement) {
+    text_.replace(position, length, replacement.data(), replacement.size());
+}
+
+void StringTape::segments(string_view& first, string_view& second) const {
+    first = text_;
+    second = string_view();
+}
+
+GapBufferTape::GapBufferTape() : gapStart_(0), gapEnd_(0) {}
+
+unique_ptr<MarkovTape> GapBufferTape::clone() const {
+    return make_unique<GapBufferTape>(*this);
+}
+
+MarkovTapeKind GapBufferTape::kind() const {
+    return MarkovTapeKind::GapBuffer;
+}
+
+// Разрыв ставится в конец: первая правка сдвигает хвост один раз
+void GapBufferTape::assign(const string& text) {
+    buffer_.assign(text.begin(), text.end());
+    buffer_.resize(text.size() + max<size_t>(64, text.size() / 8));
+    gapStart_ = text.size();
+    gapEnd_ = buffer_.size();
+}
+
+size_t GapBufferTape::size() const {
+    return buffer_.size() - (gapEnd_ - gapStart_);
+}
+
+void GapBufferTape::moveGap(size_t position) {
+    if (position < gapStart_) {
+        size_t count = gapStart_ - position;
+        memmove(buffer_.data() + gapEnd_ - count, buffer_.data() + position, count);
+        gapStart_ -= count;
+        gapEnd_ -= count;
+    } else if (position > gapStart_) {
+        size_t count = position - gapStart_;
+        memmove(buffer_.data() + gapStart_, buffer_.data() + gapEnd_, count);
+        gapStart_ += count;
+        gapEnd_ += count;
+    }
+}
+
+// Буфер растет вдвое, чтобы рост ленты обходился амортизированно O(1) на байт
+void GapBufferTape::reserveGap(size_t length) {
+    if (gapEnd_ - gapStart_ >= length) {
+        return;
+    }
+    size_t tail = buffer_.size() - gapEnd_;
+    size_t capacity = max(buffer_.size() * 2, size() + length + 64);
+    buffer_.resize(capacity);
+    memmove(buffer_.data() + capacity - tail, buffer_.data() + gapEnd_, tail);
+    gapEnd_ = capacity - tail;
+}
+
+void GapBufferTape::replace(size_t position, size_t length, string_view replacement) {
+    length = min(length, size() - position);
+    moveGap(position);
+    gapEnd_ += length;
+    reserveGap(replacement.size());
+    memcpy(buffer_.data() + gapStart_, replacement.data(), replacement.size());
+    gapStart_ += replacement.size();
+}
+
+void GapBufferTape::segments(string_view& first, string_view& second) const {
+    first = string_view(buffer_.data(), gapStart_);
+    second = string_view(buffer_.data() + gapEnd_, buffer_.size() - gapEnd_);
+}
@@ -0,0 +1,63 @@
+#ifndef MARKOVTAPE_H
+#define MARKOVTAPE_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+
+using namespace std;
+
+// String — лента в std::string, каждая замена сдвигает весь хвост.
+// GapBuffer — буфер с разрывом в месте последней правки: замена стоит
+// O(расстояние от предыдущей правки + длина замены), а правила Маркова
+// обычно переписывают ленту рядом с предыдущим местом.
+enum class MarkovTapeKind { String, GapBuffer };
+
+class MarkovTape {
+public:
+    virtual ~MarkovTape() = default;
+    static unique_ptr<MarkovTape> create(MarkovTapeKind kind);
+    virtual unique_ptr<MarkovTape> clone() const = 0;
+    virtual MarkovTapeKind kind() const = 0;
+
+    virtual void assign(const string& text) = 0;
+    virtual size_t size() const = 0;
+    virtual void replace(size_t position, size_t length, string_view replacement) = 0;
+    // Содержимое ленты по порядку — не больше двух непрерывных кусков
+    virtual void segments(string_view& first, string_view& second) const = 0;
+    string str() const;
+};
+
+class StringTape : public MarkovTape {
+private:
+    string text_;
+
+public:
+    unique_ptr<MarkovTape> clone() const override;
+    MarkovTapeKind kind() const override;
+    void assign(const string& text) override;
+    size_t size() const override;
+    void replace(size_t position, size_t length, string_view replacement) override;
+    void segments(string_view& first, string_view& second) const override;
+};
+
+class GapBufferTape : public MarkovTape {
+private:
+    vector<char> buffer_;
+    size_t gapStart_;
+    size_t gapEnd_;
+    void moveGap(size_t position);
+    void reserveGap(size_t length);
+
+public:
+    GapBufferTape();
+    unique_ptr<MarkovTape> clone() const override;
+    MarkovTapeKind kind() const override;
+    void assign(const string& text) override;
+    size_t size() const override;
+    void replace(size_t position, size_t length, string_view replacement) override;
+    void segments(string_view& first, string_view& second) const override;
+};
+
+#endif
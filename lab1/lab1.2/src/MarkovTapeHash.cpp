@@ -0,0 +1,117 @@
+#include "MarkovTapeHash.h"
+
+namespace {
+
+const uint64_t MODULUS = (uint64_t(1) << 61) - 1;
+const uint64_t BASE = 1000003;
+
+uint64_t multiply(uint64_t a, uint64_t b) {
+    unsigned __int128 product = static_cast<unsigned __int128>(a) * b;
+    uint64_t low = static_cast<uint64_t>(product & MODULUS);
+    uint64_t high = static_cast<uint64_t>(product >> 61);
+    uint64_t sum = low + high;
+    return sum >= MODULUS ? sum - MODULUS : sum;
+}
+
+uint64_t add(uint64_t a, uint64_t b) {
+    uint64_t sum = a + b;
+    return sum >= MODULUS ? sum - MODULUS : sum;
+}
+
+uint64_t subtract(uint64_t a, uint64_t b) {
+    return a >= b ? a - b : a + MODULUS - b;
+}
+
+uint64_t power(uint64_t base, uint64_t exponent) {
+    uint64_t result = 1;
+    while (exponent) {
+        if (exponent & 1) {
+            result = multiply(result, base);
+        }
+        base = multiply(base, base);
+        exponent >>= 1;
+    }
+    return result;
+}
+
+// Модуль простой, поэтому обратный элемент — B^(p - 2)
+const uint64_t INVERSE_BASE = power(BASE, MODULUS - 2);
+
+// Байт 0 не должен давать нулевое слагаемое
+uint64_t weight(unsigned char symbol) {
+    return symbol + 1;
+}
+
+unsigned char symbolAt(const MarkovTape& tape, size_t position) {
+    string_view first, second;
+    tape.segments(first, second);
+    return position < first.size() ? first[position] : second[position - first.size()];
+}
+
+}
+
+MarkovTapeHash::MarkovTapeHash() : head_(0), tail_(0), power_(1), split_(0), size_(0) {}
+
+void MarkovTapeHash::reset(const MarkovTape& tape) {
+    head_ = 0;
+    tail_ = 0;
+    power_ = 1;
+    split_ = 0;
+    size_ = tape.size();
+    string_view first, second;
+    tape.segments(first, second);
+    uint64_t factor = 1;
+    for (string_view part : {first, second}) {
+        for (char symbol : part) {
+            tail_ = add(tail_, multiply(weight(symbol), factor));
+            factor = multiply(factor, BASE);
+        }
+    }
+}
+
+// Байт переходит из начала правой части в конец левой
+void MarkovTapeHash::popTail(unsigned char symbol) {
+    head_ = add(head_, multiply(weight(symbol), power_));
+    tail_ = multiply(subtract(tail_, weight(symbol)), INVERSE_BASE);
+    power_ = multiply(power_, BASE);
+    ++split_;
+}
+
+// Последний байт левой части переходит в начало правой
+void MarkovTapeHash::pushTail(unsigned char symbol) {
+    power_ = multiply(power_, INVERSE_BASE);
+    --split_;
+    head_ = subtract(head_, multiply(weight(symbol), power_));
+    tail_ = add(multiply(tail_, BASE), weight(symbol));
+}
+
+void MarkovTapeHash::moveSplit(const MarkovTape& tape, size_t position) {
+    while (split_ < position) {
+        popTail(symbolAt(tape, split_));
+    }
+    while (split_ > position) {
+        pushTail(symbolAt(tape, split_ - 1));
+    }
+}
+
+void MarkovTapeHash::replace(const MarkovTape& tape, size_t position, string_view removed, string_view inserted) {
+    moveSplit(tape, position);
+    // Удаленные байты срезаются с начала правой части
+    uint64_t factor = 1;
+    uint64_t removedHash = 0;
+    for (unsigned char symbol : removed) {
+        removedHash = add(removedHash, multiply(weight(symbol), factor));
+        factor = multiply(factor, BASE);
+    }
+    tail_ = multiply(subtract(tail_, removedHash), power(INVERSE_BASE, removed.size()));
+    for (unsigned char symbol : inserted) {
+        head_ = add(head_, multiply(weight(symbol), power_));
+        power_ = multiply(power_, BASE);
+        ++split_;
+    }
+    size_ = size_ - removed.size() + inserted.size();
+}
+
+uint64_t MarkovTapeHash::value() const {
+    return add(add(head_, multiply(tail_, power_)), multiply(size_, 0x9E3779B9));
+}
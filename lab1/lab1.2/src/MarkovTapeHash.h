@@ -0,0 +1,35 @@
+#ifndef MARKOVTAPEHASH_H
+#define MARKOVTAPEHASH_H
+
+#include "MarkovTape.h"
+#include <cstdint>
+#include <string>
+
+using namespace std;
+
+// Полиномиальный хеш ленты по модулю 2^61 - 1, который обновляется правками.
+// Как и буфер с разрывом, хеш делит ленту точкой разрыва: левая часть хранится
+// как сумма c[i] * B^i, правая — как сумма c[s + j] * B^j. Правка в точке
+// разрыва меняет только эти суммы, а перенос разрыва стоит O(расстояние),
+// поэтому шаг обходится без прохода по всей ленте.
+class MarkovTapeHash {
+private:
+    uint64_t head_;
+    uint64_t tail_;
+    // B^split_
+    uint64_t power_;
+    size_t split_;
+    size_t size_;
+    void pushTail(unsigned char symbol);
+    void popTail(unsigned char symbol);
+    void moveSplit(const MarkovTape& tape, size_t position);
+
+public:
+    MarkovTapeHash();
+    void reset(const MarkovTape& tape);
+    // Вызывается до правки: в позиции position байты removed заменяются на inserted
+    void replace(const MarkovTape& tape, size_t position, string_view removed, string_view inserted);
+    uint64_t value() const;
+};
+
+#endif
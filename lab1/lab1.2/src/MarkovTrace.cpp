@@ -0,0 +1,217 @@
+#include "MarkovTrace.h"
+#include "MarkovTape.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+namespace {
+
+const char TRACE_MAGIC[4] = {'M', 'K', 'T', 'R'};
+const uint32_t TRACE_VERSION = 3;
+
+struct MarkovTraceHeader {
+    char magic[4];
+    uint32_t version;
+    uint64_t capacity;
+    uint64_t recorded;
+    uint64_t firstStep;
+    uint64_t checkpointCount;
+    uint32_t encoding;
+    uint32_t reserved;
+};
+
+}
+
+MarkovTrace::MarkovTrace(size_t capacity)
+    : ring_(max<size_t>(capacity, 2)), recorded_(0), firstStep_(0), checkpointInterval_(ring_.size() / 2),
+      checkpointStep_{0, 0}, checkpointCount_(0), encoding_(MarkovEncoding::Bytes) {}
+
+void MarkovTrace::begin(const string& tape, uint64_t step, MarkovEncoding encoding) {
+    encoding_ = encoding;
+    recorded_ = 0;
+    firstStep_ = step;
+    checkpointCount_ = 0;
+    checkpoint(tape, step);
+}
+
+// Старший снимок вытесняется; кольцо хранит все записи начиная с него
+void MarkovTrace::checkpoint(const string& tape, uint64_t step) {
+    if (checkpointCount_ == 2) {
+        checkpointTape_[0].swap(checkpointTape_[1]);
+        checkpointStep_[0] = checkpointStep_[1];
+        checkpointCount_ = 1;
+    }
+    checkpointTape_[checkpointCount_] = tape;
+    checkpointStep_[checkpointCount_] = step;
+    ++checkpointCount_;
+}
+
+size_t MarkovTrace::capacity() const {
+    return ring_.size();
+}
+
+size_t MarkovTrace::size() const {
+    return static_cast<size_t>(min<uint64_t>(recorded_, ring_.size()));
+}
+
+const MarkovTraceRecord& MarkovTrace::at(size_t index) const {
+    uint64_t first = recorded_ - size();
+    return ring_[(first + index) % ring_.size()];
+}
+
+uint64_t MarkovTrace::firstReplayableStep() const {
+    return checkpointCount_ ? checkpointStep_[0] : firstStep_;
+}
+
+uint64_t MarkovTrace::lastStep() const {
+    return size() ? at(size() - 1).step + 1 : firstReplayableStep();
+}
+
+bool MarkovTrace::replay(const MarkovProgram& program, uint64_t step, string& tape) const {
+    return replay(program, step, step, [&tape](uint64_t, const string& state) { tape = state; });
+}
+
+MarkovEncoding MarkovTrace::encoding() const {
+    return encoding_;
+}
+
+bool MarkovTrace::replay(const MarkovProgram& program, uint64_t from, uint64_t to,
+                         const function<void(uint64_t, const string&)>& visit) const {
+    return replay(MarkovCompiledProgram(program, encoding_), from, to, visit);
+}
+
+// Снимок кодируется так же, как машина кодирует ленту, поэтому позиции записей совпадают
+bool MarkovTrace::replay(const MarkovCompiledProgram& program, uint64_t from, uint64_t to,
+                         const function<void(uint64_t, const string&)>& visit) const {
+    if (checkpointCount_ == 0 || from > to || from < checkpointStep_[0] || to > lastStep() ||
+        program.getEncoding() != encoding_) {
+        return false;
+    }
+    bool encoded = encoding_ == MarkovEncoding::Utf8;
+    const MarkovAlphabet& alphabet = program.getAlphabet();
+    size_t base = checkpointCount_ == 2 && from >= checkpointStep_[1] ? 1 : 0;
+    GapBufferTape current;
+    string others;
+    if (encoded) {
+        string codes;
+        alphabet.encode(checkpointTape_[base], codes, others);
+        current.assign(codes);
+    } else {
+        current.assign(checkpointTape_[base]);
+    }
+    auto text = [&]() { return encoded ? alphabet.decode(current.str(), others) : current.str(); };
+    uint64_t step = checkpointStep_[base];
+    if (step >= from) {
+        visit(step, text());
+    }
+    for (size_t i = 0; i < size() && step < to; ++i) {
+        const MarkovTraceRecord& entry = at(i);
+        if (entry.step < step) {
+            continue;
+        }
+        if (entry.step != step || entry.rule >= program.ruleCount()) {
+            return false;
+        }
+        const MarkovCompiledRule& rule = program.getRule(entry.rule);
+        if (rule.patternLength != entry.removedLength || rule.replacementLength != entry.insertedLength ||
+            entry.position + entry.removedLength > current.size()) {
+            return false;
+        }
+        current.replace(entry.position, entry.removedLength, program.replacement(entry.rule));
+        ++step;
+        if (step >= from) {
+            visit(step, text());
+        }
+    }
+    return step == to;
+}
+
+bool MarkovTrace::saveToFile(const string& filename) const {
+    ofstream file(filename, ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+    MarkovTraceHeader header;
+    memcpy(header.magic, TRACE_MAGIC, sizeof(header.magic));
+    header.version = TRACE_VERSION;
+    header.capacity = ring_.size();
+    header.recorded = recorded_;
+    header.firstStep = firstStep_;
+    header.checkpointCount = checkpointCount_;
+    header.encoding = static_cast<uint32_t>(encoding_);
+    header.reserved = 0;
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    for (size_t i = 0; i < checkpointCount_; ++i) {
+        uint64_t length = checkpointTape_[i].size();
+        file.write(reinterpret_cast<const char*>(&checkpointStep_[i]), sizeof(uint64_t));
+        file.write(reinterpret_cast<const char*>(&length), sizeof(length));
+        file.write(checkpointTape_[i].data(), length);
+    }
+    for (size_t i = 0; i < size(); ++i) {
+        file.write(reinterpret_cast<const char*>(&at(i)), sizeof(MarkovTraceRecord));
+    }
+    return static_cast<bool>(file);
+}
+
+// Длины из файла сверяются с оставшимся размером до выделения памяти: обрезанный
+// или испорченный файл отвергается, а не приводит к огромной аллокации.
+// Кольцо загруженной трассы не больше числа записей в файле, поэтому у
+// незаполненной трассы capacity() может оказаться меньше исходной
+bool MarkovTrace::loadFromFile(const string& filename) {
+    ifstream file(filename, ios::binary | ios::ate);
+    if (!file.is_open()) {
+        return false;
+    }
+    uint64_t remaining = static_cast<uint64_t>(file.tellg());
+    file.seekg(0);
+    MarkovTraceHeader header;
+    if (remaining < sizeof(header) || !file.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+        memcmp(header.magic, TRACE_MAGIC, sizeof(header.magic)) != 0 || header.version != TRACE_VERSION ||
+        header.capacity < 2 || header.checkpointCount > 2 ||
+        header.encoding > static_cast<uint32_t>(MarkovEncoding::Utf8)) {
+        return false;
+    }
+    remaining -= sizeof(header);
+    vector<pair<uint64_t, string>> checkpoints;
+    for (uint64_t i = 0; i < header.checkpointCount; ++i) {
+        uint64_t step = 0;
+        uint64_t length = 0;
+        if (remaining < sizeof(step) + sizeof(length) ||
+            !file.read(reinterpret_cast<char*>(&step), sizeof(step)) ||
+            !file.read(reinterpret_cast<char*>(&length), sizeof(length))) {
+            return false;
+        }
+        remaining -= sizeof(step) + sizeof(length);
+        if (length > remaining) {
+            return false;
+        }
+        string tape(length, '\0');
+        if (!file.read(&tape[0], length)) {
+            return false;
+        }
+        remaining -= length;
+        checkpoints.emplace_back(step, std::move(tape));
+    }
+    // После снимков в файле ровно min(recorded, capacity) записей
+    uint64_t count = min(header.recorded, header.capacity);
+    if (count > remaining / sizeof(MarkovTraceRecord) || remaining != count * sizeof(MarkovTraceRecord)) {
+        return false;
+    }
+    MarkovTrace loaded(header.recorded >= header.capacity ? header.capacity : count);
+    loaded.firstStep_ = header.firstStep;
+    loaded.encoding_ = static_cast<MarkovEncoding>(header.encoding);
+    for (pair<uint64_t, string>& checkpoint : checkpoints) {
+        loaded.checkpoint(checkpoint.second, checkpoint.first);
+    }
+    // Записи кладутся на те же места кольца, что и при записи
+    loaded.recorded_ = header.recorded;
+    for (uint64_t i = 0; i < count; ++i) {
+        MarkovTraceRecord entry;
+        if (!file.read(reinterpret_cast<char*>(&entry), sizeof(entry))) {
+            return false;
+        }
+        loaded.ring_[(header.recorded - count + i) % loaded.ring_.size()] = entry;
+    }
+    *this = std::move(loaded);
+    return true;
+}
@@ -0,0 +1,83 @@
+#ifndef MARKOVTRACE_H
+#define MARKOVTRACE_H
+
+#include "MarkovProgram.h"
+#include "MarkovCompiledProgram.h"
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+struct MarkovTraceRecord {
+    // Номер шага: запись переводит ленту из состояния step в step + 1
+    uint64_t step;
+    // Лента может быть длиннее 4 ГиБ, поэтому позиция 64-битная
+    uint64_t position;
+    uint32_t rule;
+    // Длины образца и замены правила; в скомпилированной программе они 32-битные
+    uint32_t removedLength;
+    uint32_t insertedLength;
+    uint32_t reserved;
+};
+
+// Двоичная трасса прогона: записи шагов в заранее выделенном кольцевом буфере
+// вместо печати всей ленты после каждого шага. Старые записи затираются,
+// поэтому каждые capacity / 2 шагов сохраняется снимок ленты; двух последних
+// снимков и кольца хватает, чтобы восстановить любой шаг после старшего снимка.
+// Снимки — обычный текст; позиции и длины записей — в единицах ленты машины,
+// то есть в символах, если программа скомпилирована в кодировке Utf8.
+class MarkovTrace {
+private:
+    vector<MarkovTraceRecord> ring_;
+    uint64_t recorded_;
+    uint64_t firstStep_;
+    size_t checkpointInterval_;
+    string checkpointTape_[2];
+    uint64_t checkpointStep_[2];
+    size_t checkpointCount_;
+    MarkovEncoding encoding_;
+
+public:
+    explicit MarkovTrace(size_t capacity = 1 << 20);
+
+    // Начало трассы: лента в состоянии step
+    void begin(const string& tape, uint64_t step, MarkovEncoding encoding = MarkovEncoding::Bytes);
+    // true, если после этой записи машине нужно передать снимок ленты
+    bool record(uint64_t step, size_t rule, size_t position, size_t removedLength, size_t insertedLength) {
+        MarkovTraceRecord& entry = ring_[recorded_ % ring_.size()];
+        entry.step = step;
+        entry.rule = static_cast<uint32_t>(rule);
+        entry.position = position;
+        entry.removedLength = static_cast<uint32_t>(removedLength);
+        entry.insertedLength = static_cast<uint32_t>(insertedLength);
+        entry.reserved = 0;
+        ++recorded_;
+        return recorded_ % checkpointInterval_ == 0;
+    }
+    void checkpoint(const string& tape, uint64_t step);
+
+    size_t capacity() const;
+    size_t size() const;
+    // Записи по порядку, i = 0 — самая старая из сохранившихся
+    const MarkovTraceRecord& at(size_t index) const;
+    // Наименьший шаг, который можно восстановить, и шаг после последней записи
+    uint64_t firstReplayableStep() const;
+    uint64_t lastStep() const;
+    MarkovEncoding encoding() const;
+
+    // Лента после step шагов: снимок плюс применение записанных замен
+    bool replay(const MarkovProgram& program, uint64_t step, string& tape) const;
+    // Все состояния с шагами from..to за один проход
+    bool replay(const MarkovProgram& program, uint64_t from, uint64_t to,
+                const function<void(uint64_t, const string&)>& visit) const;
+    // Программа должна быть скомпилирована в той же кодировке, что и трасса
+    bool replay(const MarkovCompiledProgram& program, uint64_t from, uint64_t to,
+                const function<void(uint64_t, const string&)>& visit) const;
+
+    bool saveToFile(const string& filename) const;
+    bool loadFromFile(const string& filename);
+};
+
+#endif
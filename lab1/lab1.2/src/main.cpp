@@ -13,6 +13,9 @@ int main(){
     machine.loadTape("||+|||");
 
     machine.run();
+#ifdef MARKOV_PROFILE
+    machine.getProfile().writeCsv(cout, machine.getProgram());
+#endif
 
 
     return 0;
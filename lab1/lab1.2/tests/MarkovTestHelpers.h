@@ -0,0 +1,44 @@
+#ifndef MARKOVTESTHELPERS_H
+#define MARKOVTESTHELPERS_H
+
+#include "../src/MarkovProgram.h"
+#include <random>
+#include <string>
+
+using namespace std;
+
+// Общие для тестов случайные слова и программы и эталонный интерпретатор. Все тесты
+// собираются в один бинарник, поэтому функции inline
+
+inline string randomWord(mt19937& generator, size_t minLength, size_t maxLength, const string& alphabet) {
+    size_t length = minLength + generator() % (maxLength - minLength + 1);
+    string word;
+    for (size_t i = 0; i < length; ++i) {
+        word += alphabet[generator() % alphabet.size()];
+    }
+    return word;
+}
+
+inline MarkovProgram randomProgram(mt19937& generator, size_t ruleCount, size_t minLength, const string& alphabet) {
+    MarkovProgram program;
+    for (size_t i = 0; i < ruleCount; ++i) {
+        program.addRule(MarkovRule(randomWord(generator, minLength, 3, alphabet),
+                                   randomWord(generator, 0, 3, alphabet), generator() % 10 == 0));
+    }
+    return program;
+}
+
+// Эталонный шаг: правила по порядку, string::find с начала ленты
+inline bool referenceStep(const MarkovProgram& program, string& tape) {
+    for (int i = 0; i < program.getRuleCount(); ++i) {
+        const MarkovRule& rule = program.getRule(i);
+        size_t position = tape.find(rule.getPattern());
+        if (position != string::npos) {
+            tape.replace(position, rule.getPattern().length(), rule.getReplacement());
+            return !rule.getIsFinal();
+        }
+    }
+    return false;
+}
+
+#endif
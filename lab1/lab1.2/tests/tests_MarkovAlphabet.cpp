@@ -0,0 +1,133 @@
+#include <gtest/gtest.h>
+#include "../src/MarkovAlphabet.h"
+#include "../src/MarkovMachine.h"
+#include <random>
+
+namespace {
+
+// Перестановка слогов кириллицей: "ба" -> "аб", в конце маркер снимается
+MarkovProgram cyrillicProgram() {
+    MarkovProgram program;
+    program.addRule(MarkovRule("*б", "б*"));
+    program.addRule(MarkovRule("*а", "ая*"));
+    program.addRule(MarkovRule("*", "", true));
+    return program;
+}
+
+}
+
+TEST(MarkovAlphabetTest, EncodeDecodeRoundTrip) {
+    MarkovAlphabet alphabet;
+    ASSERT_TRUE(alphabet.build(cyrillicProgram()));
+    EXPECT_EQ(alphabet.size(), 4u);
+
+    string codes, others;
+    for (const string& text : {string("*баба"), string("x*бёa€😀"), string("\xd0") + "*\xb0\xff" + "б",
+                               string(""), string("\xe2\x82")}) {
+        alphabet.encode(text, codes, others);
+        EXPECT_EQ(alphabet.decode(codes, others), text);
+    }
+    alphabet.encode("*баба", codes, others);
+    EXPECT_EQ(codes.size(), 5u);
+    EXPECT_TRUE(others.empty());
+    EXPECT_FALSE(alphabet.encodeProgramText("ё", codes));
+}
+
+TEST(MarkovAlphabetTest, TooManySymbolsFallsBackToBytes) {
+    MarkovProgram program;
+    for (int i = 0; i < 300; ++i) {
+        string symbol;
+        symbol += static_cast<char>(0xD0 + i / 64);
+        symbol += static_cast<char>(0x80 + i % 64);
+        program.addRule(MarkovRule(symbol, ""));
+    }
+    shared_ptr<const MarkovCompiledProgram> compiled = MarkovCompiledProgram::compile(program, MarkovEncoding::Utf8);
+    EXPECT_EQ(compiled->getEncoding(), MarkovEncoding::Bytes);
+}
+
+TEST(MarkovAlphabetTest, SmallerAutomatonForCyrillic) {
+    MarkovProgram program;
+    program.addRule(MarkovRule("абв", "г"));
+    program.addRule(MarkovRule("где", "жз"));
+    auto bytes = MarkovCompiledProgram::compile(program);
+    auto utf8 = MarkovCompiledProgram::compile(program, MarkovEncoding::Utf8);
+    ASSERT_EQ(utf8->getEncoding(), MarkovEncoding::Utf8);
+    EXPECT_LT(utf8->getMatcher().stateCount(), bytes->getMatcher().stateCount());
+    EXPECT_EQ(utf8->pattern(0).size(), 3u);
+    EXPECT_EQ(utf8->getMatcher().maxPatternLength(), 3u);
+}
+
+TEST(MarkovAlphabetTest, MachineMatchesByteMode) {
+    for (MarkovSearchMode mode : {MarkovSearchMode::Scan, MarkovSearchMode::Incremental}) {
+        MarkovMachine bytes(MarkovTapeKind::GapBuffer, mode);
+        MarkovMachine utf8(MarkovTapeKind::GapBuffer, mode);
+        bytes.loadProgram(cyrillicProgram());
+        utf8.loadProgram(cyrillicProgram(), MarkovEncoding::Utf8);
+        ASSERT_EQ(utf8.getEncoding(), MarkovEncoding::Utf8);
+        string tape = "ё*бабxба€б";
+        bytes.loadTape(tape);
+        utf8.loadTape(tape);
+        EXPECT_EQ(utf8.getTape(), tape);
+        MarkovRunResult expected = bytes.run(MarkovRunOptions());
+        MarkovRunResult result = utf8.run(MarkovRunOptions());
+        EXPECT_EQ(result.tape, expected.tape);
+        EXPECT_EQ(result.steps, expected.steps);
+        EXPECT_EQ(utf8.getTape(), expected.tape);
+    }
+}
+
+// По байтам образец из хвоста символа находится внутри "а" (D0 B0)
+TEST(MarkovAlphabetTest, NoMatchInsideCodePoint) {
+    MarkovProgram program;
+    program.addRule(MarkovRule("\xb0", "!", true));
+    MarkovMachine bytes;
+    bytes.loadProgram(program);
+    bytes.loadTape("а");
+    bytes.run(MarkovRunOptions());
+    EXPECT_EQ(bytes.getTape(), "\xd0!");
+
+    MarkovMachine utf8;
+    utf8.loadProgram(program, MarkovEncoding::Utf8);
+    utf8.loadTape("а");
+    MarkovRunResult result = utf8.run(MarkovRunOptions());
+    EXPECT_EQ(result.reason, MarkovHaltReason::NoRule);
+    EXPECT_EQ(result.tape, "а");
+}
+
+TEST(MarkovAlphabetTest, ReloadProgramRecodesTape) {
+    MarkovMachine machine;
+    machine.loadProgram(cyrillicProgram(), MarkovEncoding::Utf8);
+    machine.loadTape("*ба");
+    MarkovProgram other;
+    other.addRule(MarkovRule("ба", "ы"));
+    machine.loadProgram(other, MarkovEncoding::Utf8);
+    EXPECT_EQ(machine.getTape(), "*ба");
+    EXPECT_TRUE(machine.step());
+    EXPECT_EQ(machine.getTape(), "*ы");
+    machine.loadProgram(cyrillicProgram());
+    EXPECT_EQ(machine.getTape(), "*ы");
+}
+
+TEST(MarkovAlphabetTest, TraceReplaysEncodedRun) {
+    MarkovMachine machine;
+    machine.loadProgram(cyrillicProgram(), MarkovEncoding::Utf8);
+    machine.loadTape("ё*бабаб");
+    vector<string> states;
+    MarkovMachine reference(machine);
+    states.push_back(reference.getTape());
+    while (reference.step()) {
+        states.push_back(reference.getTape());
+    }
+    states.push_back(reference.getTape());
+
+    MarkovTrace trace(64);
+    MarkovRunOptions options;
+    options.trace = &trace;
+    machine.run(options);
+    EXPECT_EQ(trace.encoding(), MarkovEncoding::Utf8);
+    for (size_t step = 0; step < states.size(); ++step) {
+        string replayed;
+        ASSERT_TRUE(trace.replay(cyrillicProgram(), step, replayed));
+        EXPECT_EQ(replayed, states[step]);
+    }
+}
@@ -0,0 +1,127 @@
+#include <gtest/gtest.h>
+#include "../src/MarkovBatchRunner.h"
+#include <random>
+
+namespace {
+
+MarkovProgram unaryAddition() {
+    MarkovProgram program;
+    program.addRule(MarkovRule("|+", "+|", false));
+    program.addRule(MarkovRule("+", "", true));
+    return program;
+}
+
+}
+
+TEST(MarkovCompiledProgramTest, SharedWithoutCopy) {
+    shared_ptr<const MarkovCompiledProgram> compiled = MarkovCompiledProgram::compile(unaryAddition());
+    EXPECT_EQ(compiled->getProgram().getRuleCount(), 2);
+    EXPECT_EQ(compiled->getMatcher().ruleCount(), 2u);
+
+    MarkovMachine first;
+    MarkovMachine second;
+    first.loadProgram(compiled);
+    second.loadProgram(compiled);
+    EXPECT_EQ(first.getCompiledProgram().get(), second.getCompiledProgram().get());
+    EXPECT_EQ(&first.getProgram(), &compiled->getProgram());
+
+    first.loadTape("||+|");
+    first.run();
+    EXPECT_EQ(first.getTape(), "|||");
+}
+
+TEST(MarkovCompiledProgramTest, InternsRuleStrings) {
+    MarkovProgram program;
+    program.addRule(MarkovRule("ab", "x"));
+    program.addRule(MarkovRule("x", "ab", true));
+    program.addRule(MarkovRule("cd", "x"));
+    program.addRule(MarkovRule("", ""));
+    shared_ptr<const MarkovCompiledProgram> compiled = MarkovCompiledProgram::compile(program);
+
+    ASSERT_EQ(compiled->ruleCount(), 4u);
+    EXPECT_EQ(compiled->poolSize(), 5u);
+    for (size_t i = 0; i < compiled->ruleCount(); ++i) {
+        EXPECT_EQ(compiled->pattern(i), program.getRule(i).getPattern());
+        EXPECT_EQ(compiled->replacement(i), program.getRule(i).getReplacement());
+        EXPECT_EQ(compiled->isFinal(i), program.getRule(i).getIsFinal());
+    }
+    EXPECT_EQ(compiled->getRule(0).patternOffset, compiled->getRule(1).replacementOffset);
+    EXPECT_EQ(compiled->getRule(0).replacementOffset, compiled->getRule(2).replacementOffset);
+}
+
+TEST(MarkovBatchRunnerTest, ResultsMatchSingleMachine) {
+    shared_ptr<const MarkovCompiledProgram> compiled = MarkovCompiledProgram::compile(unaryAddition());
+    mt19937 generator(1);
+    vector<string> tapes;
+    for (int i = 0; i < 2000; ++i) {
+        tapes.push_back(string(generator() % 50, '|') + (i % 7 == 0 ? "" : "+") + string(generator() % 50, '|'));
+    }
+
+    for (size_t threads : {1u, 4u}) {
+        MarkovBatchOptions options;
+        options.threads = threads;
+        vector<MarkovRunResult> results = MarkovBatchRunner(compiled, options).run(tapes);
+        ASSERT_EQ(results.size(), tapes.size());
+        for (size_t i = 0; i < tapes.size(); ++i) {
+            MarkovMachine machine;
+            machine.loadProgram(compiled);
+            machine.loadTape(tapes[i]);
+            while (machine.step()) {}
+            EXPECT_EQ(results[i].tape, machine.getTape());
+            EXPECT_EQ(results[i].steps, machine.getCurrentStep());
+            EXPECT_EQ(results[i].reason, i % 7 == 0 ? MarkovHaltReason::NoRule : MarkovHaltReason::FinalRule);
+        }
+    }
+}
+
+TEST(MarkovBatchRunnerTest, StepLimitStopsEndlessTape) {
+    MarkovProgram program;
+    program.addRule(MarkovRule("a", "aa"));
+    program.addRule(MarkovRule("b", "c", true));
+    shared_ptr<const MarkovCompiledProgram> compiled = MarkovCompiledProgram::compile(program);
+
+    MarkovBatchOptions options;
+    options.threads = 3;
+    options.run.maxSteps = 100;
+    vector<string> tapes = {"a", "b", "xyz", "ab"};
+    vector<MarkovRunResult> results = MarkovBatchRunner(compiled, options).run(tapes);
+    EXPECT_EQ(results[0].reason, MarkovHaltReason::StepLimit);
+    EXPECT_EQ(results[0].steps, 100u);
+    EXPECT_EQ(results[0].tape, string(101, 'a'));
+    EXPECT_EQ(results[1].reason, MarkovHaltReason::FinalRule);
+    EXPECT_EQ(results[1].tape, "c");
+    EXPECT_EQ(results[2].reason, MarkovHaltReason::NoRule);
+    EXPECT_EQ(results[2].steps, 0u);
+    EXPECT_EQ(results[3].reason, MarkovHaltReason::StepLimit);
+
+    // Лимит для отдельной ленты
+    vector<MarkovRunResult> limited = MarkovBatchRunner(compiled, options).run(tapes, {5, 5, 5, 0});
+    EXPECT_EQ(limited[0].steps, 5u);
+    EXPECT_EQ(limited[0].tape, "aaaaaa");
+    EXPECT_EQ(limited[3].steps, 0u);
+    EXPECT_EQ(limited[3].tape, "ab");
+    EXPECT_EQ(limited[3].reason, MarkovHaltReason::StepLimit);
+}
+
+TEST(MarkovBatchRunnerTest, IgnoresTrace) {
+    shared_ptr<const MarkovCompiledProgram> compiled = MarkovCompiledProgram::compile(unaryAddition());
+    MarkovTrace trace(16);
+    MarkovBatchOptions options;
+    options.threads = 4;
+    options.run.trace = &trace;
+    vector<string> tapes;
+    for (size_t i = 0; i < 64; ++i) {
+        tapes.push_back(string(i, '|') + "+" + string(i, '|'));
+    }
+    vector<MarkovRunResult> results = MarkovBatchRunner(compiled, options).run(tapes);
+    for (size_t i = 0; i < tapes.size(); ++i) {
+        EXPECT_EQ(results[i].tape, string(2 * i, '|'));
+        EXPECT_EQ(results[i].reason, MarkovHaltReason::FinalRule);
+    }
+    EXPECT_EQ(trace.size(), 0u);
+}
+
+TEST(MarkovBatchRunnerTest, EmptyBatch) {
+    shared_ptr<const MarkovCompiledProgram> compiled = MarkovCompiledProgram::compile(unaryAddition());
+    EXPECT_TRUE(MarkovBatchRunner(compiled).run({}).empty());
+}
@@ -0,0 +1,99 @@
+#include <gtest/gtest.h>
+#include "../src/MarkovMatchIndex.h"
+#include "../src/MarkovMachine.h"
+#include "MarkovTestHelpers.h"
+#include <algorithm>
+#include <random>
+
+TEST(MarkovMatchIndexTest, FindAllListsEveryOccurrence) {
+    MarkovProgram program;
+    program.addRule(MarkovRule("aa", "1"));
+    program.addRule(MarkovRule("a", "2"));
+    program.addRule(MarkovRule("aa", "3"));
+    program.addRule(MarkovRule("ba", "4"));
+    MarkovMatcher matcher(program);
+    StringTape tape;
+    tape.assign("baaab");
+
+    vector<MarkovMatch> matches;
+    matcher.findAll(tape, 0, tape.size(), tape.size(), matches);
+    vector<pair<size_t, size_t>> found;
+    for (const MarkovMatch& match : matches) {
+        found.push_back(make_pair(match.rule, match.position));
+    }
+    sort(found.begin(), found.end());
+    vector<pair<size_t, size_t>> expected = {{0, 1}, {0, 2}, {1, 1}, {1, 2}, {1, 3}, {2, 1}, {2, 2}, {3, 0}};
+    EXPECT_EQ(found, expected);
+
+    // Только начала левее startLimit и только внутри [from, to)
+    matches.clear();
+    matcher.findAll(tape, 1, 4, 2, matches);
+    EXPECT_EQ(matches.size(), 3u);
+}
+
+TEST(MarkovMatchIndexTest, UpdateMatchesRebuild) {
+    mt19937 generator(9);
+    const string alphabet = "abc";
+    for (int round = 0; round < 50; ++round) {
+        MarkovProgram program = randomProgram(generator, 6, 1, alphabet);
+        MarkovMatcher matcher(program);
+        GapBufferTape tape;
+        tape.assign(randomWord(generator, 0, 40, alphabet));
+        MarkovMatchIndex index;
+        index.build(matcher, tape);
+        for (int edit = 0; edit < 100; ++edit) {
+            size_t position = generator() % (tape.size() + 1);
+            size_t removed = min<size_t>(generator() % 4, tape.size() - position);
+            string replacement = randomWord(generator, 0, 4, alphabet);
+            tape.replace(position, removed, replacement);
+            index.update(matcher, tape, position, removed, replacement.size());
+
+            MarkovMatchIndex rebuilt;
+            rebuilt.build(matcher, tape);
+            ASSERT_EQ(index.matchCount(), rebuilt.matchCount()) << tape.str();
+            MarkovMatch actual{0, 0};
+            MarkovMatch expected{0, 0};
+            ASSERT_EQ(index.first(matcher, actual), rebuilt.first(matcher, expected));
+            EXPECT_EQ(actual.rule, expected.rule);
+            EXPECT_EQ(actual.position, expected.position);
+        }
+    }
+}
+
+TEST(MarkovMatchIndexTest, IncrementalMachineMatchesReference) {
+    mt19937 generator(41);
+    const string alphabet = "ab*|";
+    for (int round = 0; round < 200; ++round) {
+        MarkovProgram program = randomProgram(generator, 1 + generator() % 8, round % 5 == 0 ? 0 : 1, alphabet);
+        string start = randomWord(generator, 0, 30, alphabet);
+        for (MarkovTapeKind kind : {MarkovTapeKind::String, MarkovTapeKind::GapBuffer}) {
+            MarkovMachine machine(kind, MarkovSearchMode::Incremental);
+            machine.loadProgram(program);
+            machine.loadTape(start);
+            string reference = start;
+            for (int step = 0; step < 300; ++step) {
+                bool expectedContinue = referenceStep(program, reference);
+                ASSERT_EQ(machine.step(), expectedContinue);
+                ASSERT_EQ(machine.getTape(), reference) << "round " << round << " step " << step;
+                if (!expectedContinue) {
+                    break;
+                }
+            }
+        }
+    }
+}
+
+TEST(MarkovMatchIndexTest, ReloadInvalidatesIndex) {
+    MarkovProgram program;
+    program.addRule(MarkovRule("ab", "ba"));
+    MarkovMachine machine(MarkovTapeKind::GapBuffer, MarkovSearchMode::Incremental);
+    machine.loadProgram(program);
+    machine.loadTape("aab");
+    EXPECT_TRUE(machine.step());
+    EXPECT_EQ(machine.getTape(), "aba");
+    machine.loadTape("bbab");
+    EXPECT_TRUE(machine.step());
+    EXPECT_EQ(machine.getTape(), "bbba");
+    EXPECT_FALSE(machine.step());
+    EXPECT_EQ(machine.getSearchMode(), MarkovSearchMode::Incremental);
+}
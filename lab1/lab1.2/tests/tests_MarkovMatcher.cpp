@@ -0,0 +1,124 @@
+#include <gtest/gtest.h>
+#include "../src/MarkovMatcher.h"
+#include "../src/MarkovMachine.h"
+#include "MarkovTestHelpers.h"
+#include <random>
+
+namespace {
+
+// Эталон: правила по порядку, самое левое вхождение через string::find
+bool referenceFind(const MarkovProgram& program, const string& tape, MarkovMatch& match) {
+    for (int i = 0; i < program.getRuleCount(); ++i) {
+        size_t position = tape.find(program.getRule(i).getPattern());
+        if (position != string::npos) {
+            match.rule = i;
+            match.position = position;
+            return true;
+        }
+    }
+    return false;
+}
+
+}
+
+TEST(MarkovMatcherTest, EmptyProgram) {
+    MarkovMatcher matcher(MarkovProgram{});
+    MarkovMatch match;
+    EXPECT_FALSE(matcher.find("abc", match));
+    EXPECT_FALSE(matcher.find("", match));
+    EXPECT_EQ(matcher.ruleCount(), 0u);
+}
+
+TEST(MarkovMatcherTest, PriorityBeatsPosition) {
+    MarkovProgram program;
+    program.addRule(MarkovRule("cd", "x"));
+    program.addRule(MarkovRule("ab", "y"));
+    program.addRule(MarkovRule("b", "z"));
+    MarkovMatcher matcher(program);
+
+    MarkovMatch match;
+    ASSERT_TRUE(matcher.find("abcdcd", match));
+    EXPECT_EQ(match.rule, 0u);
+    EXPECT_EQ(match.position, 2u);
+
+    ASSERT_TRUE(matcher.find("xbab", match));
+    EXPECT_EQ(match.rule, 1u);
+    EXPECT_EQ(match.position, 2u);
+
+    ASSERT_TRUE(matcher.find("xxb", match));
+    EXPECT_EQ(match.rule, 2u);
+    EXPECT_EQ(match.position, 2u);
+    EXPECT_FALSE(matcher.find("xyz", match));
+}
+
+TEST(MarkovMatcherTest, NestedAndSuffixPatterns) {
+    MarkovProgram program;
+    program.addRule(MarkovRule("abcd", "1"));
+    program.addRule(MarkovRule("bc", "2"));
+    program.addRule(MarkovRule("c", "3"));
+    MarkovMatcher matcher(program);
+
+    MarkovMatch match;
+    // "bc" найдено через суффиксную ссылку внутри "abc"
+    ASSERT_TRUE(matcher.find("abce", match));
+    EXPECT_EQ(match.rule, 1u);
+    EXPECT_EQ(match.position, 1u);
+    ASSERT_TRUE(matcher.find("xabcabcd", match));
+    EXPECT_EQ(match.rule, 0u);
+    EXPECT_EQ(match.position, 4u);
+}
+
+TEST(MarkovMatcherTest, EmptyPatternMatchesAtStart) {
+    MarkovProgram program;
+    program.addRule(MarkovRule("a", "b"));
+    program.addRule(MarkovRule("", "x"));
+    MarkovMatcher matcher(program);
+
+    MarkovMatch match;
+    ASSERT_TRUE(matcher.find("cca", match));
+    EXPECT_EQ(match.rule, 0u);
+    ASSERT_TRUE(matcher.find("ccc", match));
+    EXPECT_EQ(match.rule, 1u);
+    EXPECT_EQ(match.position, 0u);
+    ASSERT_TRUE(matcher.find("", match));
+    EXPECT_EQ(match.rule, 1u);
+}
+
+TEST(MarkovMatcherTest, MatchesReferenceOnRandomPrograms) {
+    mt19937 generator(2024);
+    const string alphabet = "ab|+\xd0\xb0";
+    for (int round = 0; round < 300; ++round) {
+        MarkovProgram program;
+        size_t ruleCount = 1 + generator() % 30;
+        for (size_t i = 0; i < ruleCount; ++i) {
+            program.addRule(MarkovRule(randomWord(generator, round % 10 == 0 ? 0 : 1, 5, alphabet), "r"));
+        }
+        MarkovMatcher matcher(program);
+        for (int t = 0; t < 20; ++t) {
+            string tape = randomWord(generator, 0, 60, alphabet);
+            MarkovMatch expected{0, 0};
+            MarkovMatch actual{0, 0};
+            bool found = referenceFind(program, tape, expected);
+            ASSERT_EQ(matcher.find(tape, actual), found) << tape;
+            if (found) {
+                EXPECT_EQ(actual.rule, expected.rule) << tape;
+                EXPECT_EQ(actual.position, expected.position) << tape;
+            }
+        }
+    }
+}
+
+TEST(MarkovMatcherTest, MachineRunsLikeReference) {
+    MarkovProgram program;
+    program.addRule(MarkovRule("*a", "aa*"));
+    program.addRule(MarkovRule("*b", "bb*"));
+    program.addRule(MarkovRule("*", "", true));
+    program.addRule(MarkovRule("", "*"));
+
+    MarkovMachine machine;
+    machine.loadProgram(program);
+    machine.loadTape("abba");
+    while (machine.step()) {}
+    EXPECT_EQ(machine.getTape(), "aabbbbaa");
+    EXPECT_EQ(machine.getCurrentStep(), 6);
+}
@@ -0,0 +1,103 @@
+#include <gtest/gtest.h>
+#include "../src/MarkovMachine.h"
+#include "../src/MarkovProfile.h"
+#include <sstream>
+
+TEST(MarkovProfileTest, TriedCountsStepsReachingRule) {
+    MarkovProfile profile;
+    profile.reset(3);
+    profile.recordMatch(0, 5, 1);
+    profile.recordMatch(2, 10, 0);
+    profile.recordMatch(1, 7, 2);
+    profile.recordNoMatch(4);
+
+    vector<MarkovRuleCounters> counters = profile.counters();
+    ASSERT_EQ(counters.size(), 3u);
+    EXPECT_EQ(profile.steps(), 4u);
+    EXPECT_EQ(counters[0].tried, 4u);
+    EXPECT_EQ(counters[1].tried, 3u);
+    EXPECT_EQ(counters[2].tried, 2u);
+    EXPECT_EQ(counters[0].matched, 1u);
+    EXPECT_EQ(counters[1].matched, 1u);
+    EXPECT_EQ(counters[2].matched, 1u);
+    EXPECT_EQ(counters[2].bytesScanned, 10u);
+    EXPECT_EQ(counters[1].bytesRewritten, 2u);
+}
+
+TEST(MarkovProfileTest, ExportsCsvAndJson) {
+    MarkovProgram program;
+    program.addRule(MarkovRule("a\"", "b"));
+    program.addRule(MarkovRule("c", "", true));
+    MarkovProfile profile;
+    profile.reset(2);
+    profile.recordMatch(0, 3, 1);
+
+    ostringstream csv;
+    profile.writeCsv(csv, program);
+    EXPECT_EQ(csv.str(),
+              "rule,pattern,replacement,final,tried,matched,bytes_scanned,bytes_rewritten\n"
+              "0,\"a\"\"\",\"b\",0,1,1,3,1\n"
+              "1,\"c\",\"\",1,0,0,0,0\n");
+
+    ostringstream json;
+    profile.writeJson(json, program);
+    EXPECT_EQ(json.str(),
+              "{\"steps\":1,\"unmatched_steps\":0,\"unmatched_bytes_scanned\":0,\"rules\":["
+              "{\"rule\":0,\"pattern\":\"a\\\"\",\"replacement\":\"b\",\"final\":false,\"tried\":1,"
+              "\"matched\":1,\"bytes_scanned\":3,\"bytes_rewritten\":1},"
+              "{\"rule\":1,\"pattern\":\"c\",\"replacement\":\"\",\"final\":true,\"tried\":0,"
+              "\"matched\":0,\"bytes_scanned\":0,\"bytes_rewritten\":0}]}\n");
+}
+
+// Счетчики машины есть только в сборке make test-profile
+#ifdef MARKOV_PROFILE
+class MarkovMachineProfileTest : public ::testing::TestWithParam<MarkovSearchMode> {};
+
+TEST_P(MarkovMachineProfileTest, CountsRulesOfRun) {
+    MarkovProgram program;
+    program.addRule(MarkovRule("|+", "+|"));
+    program.addRule(MarkovRule("+", "", true));
+    program.addRule(MarkovRule("never", "x"));
+    MarkovMachine machine(MarkovTapeKind::GapBuffer, GetParam());
+    machine.loadProgram(program);
+    machine.loadTape("||+|||");
+    machine.run(MarkovRunOptions());
+
+    vector<MarkovRuleCounters> counters = machine.getProfile().counters();
+    ASSERT_EQ(counters.size(), 3u);
+    EXPECT_EQ(machine.getProfile().steps(), 3u);
+    EXPECT_EQ(counters[0].tried, 3u);
+    EXPECT_EQ(counters[0].matched, 2u);
+    EXPECT_EQ(counters[0].bytesRewritten, 4u);
+    EXPECT_EQ(counters[1].tried, 1u);
+    EXPECT_EQ(counters[1].matched, 1u);
+    EXPECT_EQ(counters[1].bytesRewritten, 0u);
+    EXPECT_EQ(counters[2].tried, 0u);
+    EXPECT_EQ(counters[2].matched, 0u);
+    EXPECT_GT(counters[0].bytesScanned, 0u);
+    EXPECT_GT(counters[1].bytesScanned, 0u);
+
+    machine.resetProfile();
+    EXPECT_EQ(machine.getProfile().steps(), 0u);
+    machine.loadTape("xyz");
+    EXPECT_FALSE(machine.step());
+    counters = machine.getProfile().counters();
+    EXPECT_EQ(counters[2].tried, 1u);
+    EXPECT_EQ(counters[0].matched + counters[1].matched + counters[2].matched, 0u);
+}
+
+TEST(MarkovMachineProfileScanTest, ScannedBytesStopAtMatch) {
+    MarkovProgram program;
+    program.addRule(MarkovRule("b", "c"));
+    MarkovMachine machine;
+    machine.loadProgram(program);
+    machine.loadTape("aaab" + string(100, 'a'));
+    ASSERT_TRUE(machine.step());
+    EXPECT_EQ(machine.getProfile().counters()[0].bytesScanned, 4u);
+    EXPECT_FALSE(machine.step());
+    EXPECT_GE(machine.getProfile().counters()[0].tried, 2u);
+}
+
+INSTANTIATE_TEST_SUITE_P(SearchModes, MarkovMachineProfileTest,
+                         ::testing::Values(MarkovSearchMode::Scan, MarkovSearchMode::Incremental));
+#endif
@@ -1,5 +1,7 @@
 #include <gtest/gtest.h>
 #include "../src/MarkovProgram.h"
+#include <cstdio>
+#include <fstream>
 
 TEST(MarkovProgramTest, DefaultConstructor) {
     MarkovProgram program;
@@ -150,4 +152,116 @@ TEST(MarkovProgramTest, InputOperatorEmpty) {
     iss >> program; // Должен очистить правила
     
     EXPECT_EQ(program.getRuleCount(), 0);
-}
\ No newline at end of file
+}
+TEST(MarkovProgramTest, DuplicatesAfterRemoveAndModify) {
+    MarkovProgram program;
+    for (int i = 0; i < 100; ++i) {
+        program.addRule(MarkovRule("a" + to_string(i), "b"));
+    }
+    program.addRule(MarkovRule("a50", "b"));
+    EXPECT_EQ(program.getRuleCount(), 100);
+
+    EXPECT_TRUE(program.removeRule("a50", "b"));
+    program.addRule(MarkovRule("a50", "b"));
+    EXPECT_EQ(program.getRuleCount(), 100);
+    EXPECT_EQ(program.getRule(99).getPattern(), "a50");
+
+    program.modifyRule(0, "x", "y", false);
+    program.addRule(MarkovRule("x", "y"));
+    program.addRule(MarkovRule("a0", "b"));
+    EXPECT_EQ(program.getRuleCount(), 101);
+    EXPECT_EQ(program.getRule(100).getPattern(), "a0");
+}
+
+class MarkovProgramFileTest : public ::testing::Test {
+protected:
+    const string filename = "test_program.mkp";
+
+    void TearDown() override {
+        remove(filename.c_str());
+    }
+
+    void write(const string& content) {
+        ofstream file(filename, ios::binary);
+        file << content;
+    }
+};
+
+TEST_F(MarkovProgramFileTest, TextMatchesInputOperator) {
+    string text = "  a -> b  \n|+ -> +| \n+ ->  [FINAL]\nno arrow\na -> b\n\nignored -> x\n";
+    write(text);
+    MarkovProgram loaded;
+    ASSERT_TRUE(loaded.loadFromFile(filename));
+    stringstream in(text);
+    MarkovProgram expected;
+    in >> expected;
+
+    ASSERT_EQ(loaded.getRuleCount(), 4);
+    ASSERT_EQ(loaded.getRuleCount(), expected.getRuleCount());
+    for (int i = 0; i < loaded.getRuleCount(); ++i) {
+        EXPECT_EQ(loaded.getRule(i).getPattern(), expected.getRule(i).getPattern());
+        EXPECT_EQ(loaded.getRule(i).getReplacement(), expected.getRule(i).getReplacement());
+        EXPECT_EQ(loaded.getRule(i).getIsFinal(), expected.getRule(i).getIsFinal());
+    }
+    EXPECT_EQ(loaded.getRule(2).getPattern(), "+");
+    EXPECT_TRUE(loaded.getRule(2).getIsFinal());
+    EXPECT_EQ(loaded.getRule(3).getPattern(), "");
+}
+
+TEST_F(MarkovProgramFileTest, LastLineWithoutNewline) {
+    write("a -> b\nc -> d [FINAL]");
+    MarkovProgram program;
+    ASSERT_TRUE(program.loadFromFile(filename));
+    ASSERT_EQ(program.getRuleCount(), 2);
+    EXPECT_TRUE(program.getRule(1).getIsFinal());
+}
+
+TEST_F(MarkovProgramFileTest, BinaryRoundTrip) {
+    MarkovProgram program;
+    program.addRule(MarkovRule("|+", "+|"));
+    program.addRule(MarkovRule("", "x"));
+    program.addRule(MarkovRule("+", "", true));
+    program.addRule(MarkovRule("->", " a b "));
+    ASSERT_TRUE(program.saveToFile(filename, MarkovProgramFormat::Binary));
+
+    MarkovProgram loaded;
+    loaded.addRule(MarkovRule("old", "rule"));
+    ASSERT_TRUE(loaded.loadFromFile(filename));
+    ASSERT_EQ(loaded.getRuleCount(), program.getRuleCount());
+    for (int i = 0; i < program.getRuleCount(); ++i) {
+        EXPECT_EQ(loaded.getRule(i).getPattern(), program.getRule(i).getPattern());
+        EXPECT_EQ(loaded.getRule(i).getReplacement(), program.getRule(i).getReplacement());
+        EXPECT_EQ(loaded.getRule(i).getIsFinal(), program.getRule(i).getIsFinal());
+    }
+    loaded.addRule(MarkovRule("->", " a b "));
+    EXPECT_EQ(loaded.getRuleCount(), program.getRuleCount());
+}
+
+TEST_F(MarkovProgramFileTest, TextRoundTrip) {
+    MarkovProgram program;
+    program.addRule(MarkovRule("a", "b"));
+    program.addRule(MarkovRule("c", "", true));
+    ASSERT_TRUE(program.saveToFile(filename));
+    MarkovProgram loaded;
+    ASSERT_TRUE(loaded.loadFromFile(filename));
+    ASSERT_EQ(loaded.getRuleCount(), 2);
+    EXPECT_TRUE(loaded.getRule(1).getIsFinal());
+}
+
+TEST_F(MarkovProgramFileTest, CorruptBinaryLeavesProgramUnchanged) {
+    MarkovProgram program;
+    program.addRule(MarkovRule("abc", "def"));
+    ASSERT_TRUE(program.saveToFile(filename, MarkovProgramFormat::Binary));
+    {
+        ifstream file(filename, ios::binary);
+        string data((istreambuf_iterator<char>(file)), istreambuf_iterator<char>());
+        data.resize(data.size() - 2);
+        write(data);
+    }
+    MarkovProgram loaded;
+    loaded.addRule(MarkovRule("old", "rule"));
+    EXPECT_FALSE(loaded.loadFromFile(filename));
+    ASSERT_EQ(loaded.getRuleCount(), 1);
+    EXPECT_EQ(loaded.getRule(0).getPattern(), "old");
+    EXPECT_FALSE(loaded.loadFromFile("missing_program.mkp"));
+}
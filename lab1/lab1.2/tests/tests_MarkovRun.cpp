@@ -0,0 +1,144 @@
+#include <gtest/gtest.h>
+#include "../src/MarkovMachine.h"
+#include "../src/MarkovTapeHash.h"
+#include <random>
+
+TEST(MarkovTapeHashTest, IncrementalMatchesRecomputed) {
+    mt19937 generator(5);
+    GapBufferTape tape;
+    tape.assign("abcabc");
+    MarkovTapeHash hash;
+    hash.reset(tape);
+    for (int i = 0; i < 3000; ++i) {
+        size_t position = generator() % (tape.size() + 1);
+        size_t length = min<size_t>(generator() % 3, tape.size() - position);
+        string removed = tape.str().substr(position, length);
+        string inserted(generator() % 4, static_cast<char>('a' + generator() % 3));
+        hash.replace(tape, position, removed, inserted);
+        tape.replace(position, length, inserted);
+
+        MarkovTapeHash fresh;
+        fresh.reset(tape);
+        ASSERT_EQ(hash.value(), fresh.value()) << tape.str();
+    }
+}
+
+TEST(MarkovTapeHashTest, DistinguishesTapes) {
+    StringTape first, second;
+    first.assign("ab");
+    second.assign("ba");
+    MarkovTapeHash a, b;
+    a.reset(first);
+    b.reset(second);
+    EXPECT_NE(a.value(), b.value());
+    second.assign(string(1, '\0') + "ab");
+    b.reset(second);
+    EXPECT_NE(a.value(), b.value());
+}
+
+class MarkovRunTest : public ::testing::Test {
+protected:
+    MarkovMachine machineFor(const MarkovProgram& program, const string& tape) {
+        MarkovMachine machine;
+        machine.loadProgram(program);
+        machine.loadTape(tape);
+        return machine;
+    }
+};
+
+TEST_F(MarkovRunTest, HaltReasons) {
+    MarkovProgram program;
+    program.addRule(MarkovRule("|+", "+|", false));
+    program.addRule(MarkovRule("+", "", true));
+
+    MarkovMachine machine = machineFor(program, "||+|");
+    MarkovRunResult result = machine.run(MarkovRunOptions());
+    EXPECT_EQ(result.reason, MarkovHaltReason::FinalRule);
+    EXPECT_EQ(result.steps, 3u);
+    EXPECT_EQ(result.tape, "|||");
+
+    machine.loadTape("|||");
+    result = machine.run(MarkovRunOptions());
+    EXPECT_EQ(result.reason, MarkovHaltReason::NoRule);
+    EXPECT_EQ(result.steps, 0u);
+
+    MarkovRunOptions options;
+    options.maxSteps = 1;
+    machine.loadTape("||+|");
+    result = machine.run(options);
+    EXPECT_EQ(result.reason, MarkovHaltReason::StepLimit);
+    EXPECT_EQ(result.tape, "|+||");
+    // Следующий прогон продолжает с того же места
+    result = machine.run(MarkovRunOptions());
+    EXPECT_EQ(result.reason, MarkovHaltReason::FinalRule);
+    EXPECT_EQ(result.steps, 3u);
+}
+
+TEST_F(MarkovRunTest, DeadlineStopsEndlessProgram) {
+    MarkovProgram program;
+    program.addRule(MarkovRule("a", "b"));
+    program.addRule(MarkovRule("b", "a"));
+    MarkovMachine machine = machineFor(program, "a");
+    MarkovRunOptions options;
+    options.timeout = chrono::milliseconds(20);
+    MarkovRunResult result = machine.run(options);
+    EXPECT_EQ(result.reason, MarkovHaltReason::Deadline);
+    EXPECT_GT(result.steps, 0u);
+}
+
+TEST_F(MarkovRunTest, DetectsCycle) {
+    MarkovProgram program;
+    program.addRule(MarkovRule("*a", "a*"));
+    program.addRule(MarkovRule("*", "", false));
+    program.addRule(MarkovRule("a", "*a"));
+    // "*aa" -> "a*a" -> "aa*" -> "aa" -> "*aa": цикл длиной 4
+    for (MarkovSearchMode mode : {MarkovSearchMode::Scan, MarkovSearchMode::Incremental}) {
+        MarkovMachine machine(MarkovTapeKind::GapBuffer, mode);
+        machine.loadProgram(program);
+        machine.loadTape("*aa");
+        MarkovRunOptions options;
+        options.detectCycles = true;
+        options.maxSteps = 1000;
+        MarkovRunResult result = machine.run(options);
+        EXPECT_EQ(result.reason, MarkovHaltReason::Cycle);
+        EXPECT_EQ(result.steps, 4u);
+        EXPECT_EQ(result.cycleStart, 0u);
+        EXPECT_EQ(result.tape, "*aa");
+    }
+}
+
+// Совпавший хеш сверяется с лентой, восстановленной от начала прогона: это
+// должно работать и со сдвинутым счетчиком шагов, и с лентой в кодах алфавита
+TEST_F(MarkovRunTest, CycleIsConfirmedByReplay) {
+    MarkovProgram program;
+    program.addRule(MarkovRule("*а", "а*"));
+    program.addRule(MarkovRule("*", "", false));
+    program.addRule(MarkovRule("а", "*а"));
+    for (MarkovEncoding encoding : {MarkovEncoding::Bytes, MarkovEncoding::Utf8}) {
+        MarkovMachine machine;
+        machine.loadProgram(program, encoding);
+        machine.loadTape("ж*аа");
+        machine.setCurrentStep(7);
+        MarkovRunOptions options;
+        options.detectCycles = true;
+        options.maxSteps = 1000;
+        MarkovRunResult result = machine.run(options);
+        EXPECT_EQ(result.reason, MarkovHaltReason::Cycle);
+        EXPECT_EQ(result.cycleStart, 7u);
+        EXPECT_EQ(result.steps, 11u);
+        EXPECT_EQ(result.tape, "ж*аа");
+    }
+}
+
+TEST_F(MarkovRunTest, GrowingTapeIsNotACycle) {
+    MarkovProgram program;
+    program.addRule(MarkovRule("a", "ba"));
+    MarkovMachine machine = machineFor(program, "a");
+    MarkovRunOptions options;
+    options.detectCycles = true;
+    options.cycleTableSize = 64;
+    options.maxSteps = 5000;
+    MarkovRunResult result = machine.run(options);
+    EXPECT_EQ(result.reason, MarkovHaltReason::StepLimit);
+    EXPECT_EQ(result.tape.size(), 5001u);
+}
@@ -0,0 +1,94 @@
+#include <gtest/gtest.h>
+#include "../src/MarkovSearch.h"
+#include "../src/MarkovMatcher.h"
+#include <random>
+
+namespace {
+
+const MarkovSearchKernel KERNELS[] = {MarkovSearchKernel::Scalar, MarkovSearchKernel::SSE2, MarkovSearchKernel::AVX2};
+
+string randomText(mt19937& generator, size_t length, char alphabet) {
+    string text;
+    for (size_t i = 0; i < length; ++i) {
+        text += static_cast<char>('a' + generator() % alphabet);
+    }
+    return text;
+}
+
+}
+
+TEST(MarkovSearchTest, MatchesStringFind) {
+    mt19937 generator(17);
+    for (MarkovSearchKernel kernel : KERNELS) {
+        if (!markovSearchKernelSupported(kernel)) {
+            continue;
+        }
+        for (int i = 0; i < 20000; ++i) {
+            char alphabet = static_cast<char>(1 + generator() % 4);
+            string text = randomText(generator, generator() % 150, alphabet);
+            string pattern = randomText(generator, 1 + generator() % 6, alphabet);
+            if (generator() % 4 == 0 && !text.empty()) {
+                size_t start = generator() % text.size();
+                pattern = text.substr(start, 1 + generator() % 8);
+            }
+            ASSERT_EQ(markovFind(kernel, text, pattern), text.find(pattern))
+                << static_cast<int>(kernel) << " '" << text << "' '" << pattern << "'";
+        }
+    }
+}
+
+TEST(MarkovSearchTest, EdgeCases) {
+    for (MarkovSearchKernel kernel : KERNELS) {
+        EXPECT_EQ(markovFind(kernel, "", ""), 0u);
+        EXPECT_EQ(markovFind(kernel, "abc", ""), 0u);
+        EXPECT_EQ(markovFind(kernel, "", "a"), string_view::npos);
+        EXPECT_EQ(markovFind(kernel, "ab", "abc"), string_view::npos);
+        string text(100, 'a');
+        text[99] = 'b';
+        EXPECT_EQ(markovFind(kernel, text, "ab"), 98u);
+        EXPECT_EQ(markovFind(kernel, text, "b"), 99u);
+        text[40] = '\xff';
+        EXPECT_EQ(markovFind(kernel, text, string("\xff") + "a"), 40u);
+    }
+    EXPECT_TRUE(markovSearchKernelSupported(markovSearchKernel()));
+}
+
+// Единственный кандидат ищется векторно; ответ должен совпадать с
+// поиском по программе правил на ленте, разрезанной в случайном месте
+TEST(MarkovSearchTest, MatcherSinglePatternAcrossSegments) {
+    mt19937 generator(23);
+    for (int i = 0; i < 5000; ++i) {
+        string text = randomText(generator, generator() % 120, 3);
+        string pattern = randomText(generator, 1 + generator() % 4, 3);
+        MarkovProgram program;
+        program.addRule(MarkovRule(pattern, "x"));
+        program.addRule(MarkovRule(pattern, "y"));
+        MarkovMatcher matcher(program);
+
+        size_t split = text.empty() ? 0 : generator() % (text.size() + 1);
+        size_t from = text.empty() ? 0 : generator() % (text.size() + 1);
+        MarkovMatch match;
+        bool found = matcher.find(string_view(text).substr(0, split), string_view(text).substr(split), from,
+                                  MarkovMatcher::NO_RULE, match);
+        size_t expected = text.find(pattern, from);
+        ASSERT_EQ(found, expected != string::npos) << text << " " << pattern << " " << split << " " << from;
+        if (found) {
+            EXPECT_EQ(match.rule, 0u);
+            EXPECT_EQ(match.position, expected);
+        }
+    }
+}
+
+TEST(MarkovSearchTest, RestartLimitedToFirstRule) {
+    MarkovProgram program;
+    program.addRule(MarkovRule("ab", "x"));
+    program.addRule(MarkovRule("c", "y"));
+    MarkovMatcher matcher(program);
+    MarkovMatch match;
+    ASSERT_TRUE(matcher.find("ccab", 4, match));
+    EXPECT_EQ(match.rule, 0u);
+    EXPECT_EQ(match.position, 2u);
+    EXPECT_FALSE(matcher.find(string_view("ccab"), string_view(), 3, 1, match));
+    ASSERT_TRUE(matcher.find(string_view("cca"), string_view("b"), 1, 1, match));
+    EXPECT_EQ(match.position, 2u);
+}
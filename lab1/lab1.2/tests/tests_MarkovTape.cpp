@@ -0,0 +1,102 @@
+#include <gtest/gtest.h>
+#include "../src/MarkovTape.h"
+#include "../src/MarkovMachine.h"
+#include "MarkovTestHelpers.h"
+#include <random>
+
+TEST(MarkovTapeTest, GapBufferMatchesString) {
+    mt19937 generator(3);
+    GapBufferTape gap;
+    StringTape plain;
+    gap.assign("initial");
+    plain.assign("initial");
+    for (int i = 0; i < 5000; ++i) {
+        size_t position = generator() % (plain.size() + 1);
+        size_t length = generator() % 4;
+        string replacement = randomWord(generator, 0, i % 7 == 0 ? 200 : 5, "xyz");
+        gap.replace(position, length, replacement);
+        plain.replace(position, length, replacement);
+        ASSERT_EQ(gap.size(), plain.size());
+    }
+    EXPECT_EQ(gap.str(), plain.str());
+
+    string_view first, second;
+    gap.segments(first, second);
+    EXPECT_EQ(first.size() + second.size(), gap.size());
+}
+
+TEST(MarkovTapeTest, CloneIsIndependent) {
+    unique_ptr<MarkovTape> tape = MarkovTape::create(MarkovTapeKind::GapBuffer);
+    tape->assign("abc");
+    unique_ptr<MarkovTape> copy = tape->clone();
+    tape->replace(1, 1, "XYZ");
+    EXPECT_EQ(tape->str(), "aXYZc");
+    EXPECT_EQ(copy->str(), "abc");
+    EXPECT_EQ(copy->kind(), MarkovTapeKind::GapBuffer);
+}
+
+TEST(MarkovTapeTest, MatcherScansAcrossGap) {
+    MarkovProgram program;
+    program.addRule(MarkovRule("cd", "x"));
+    MarkovMatcher matcher(program);
+    GapBufferTape tape;
+    tape.assign("abcdef");
+    tape.replace(3, 0, "");
+    string_view first, second;
+    tape.segments(first, second);
+    ASSERT_EQ(first, "abc");
+
+    MarkovMatch match;
+    ASSERT_TRUE(matcher.find(tape, 0, MarkovMatcher::NO_RULE, match));
+    EXPECT_EQ(match.position, 2u);
+    EXPECT_FALSE(matcher.find(tape, 3, MarkovMatcher::NO_RULE, match));
+    EXPECT_FALSE(matcher.find(tape, 0, 0, match));
+}
+
+TEST(MarkovTapeTest, MachineMatchesReferenceOnBothTapes) {
+    mt19937 generator(77);
+    const string alphabet = "ab*|";
+    for (int round = 0; round < 200; ++round) {
+        MarkovProgram program;
+        size_t ruleCount = 1 + generator() % 8;
+        for (size_t i = 0; i < ruleCount; ++i) {
+            string pattern = randomWord(generator, round % 5 == 0 ? 0 : 1, 3, alphabet);
+            string replacement = randomWord(generator, 0, 3, alphabet);
+            program.addRule(MarkovRule(pattern, replacement, generator() % 10 == 0));
+        }
+        string start = randomWord(generator, 0, 30, alphabet);
+
+        for (MarkovTapeKind kind : {MarkovTapeKind::String, MarkovTapeKind::GapBuffer}) {
+            MarkovMachine machine(kind);
+            machine.loadProgram(program);
+            machine.loadTape(start);
+            string reference = start;
+            for (int step = 0; step < 300; ++step) {
+                bool expectedContinue = referenceStep(program, reference);
+                bool actualContinue = machine.step();
+                ASSERT_EQ(actualContinue, expectedContinue);
+                ASSERT_EQ(machine.getTape(), reference) << "round " << round << " step " << step;
+                if (!actualContinue) {
+                    break;
+                }
+            }
+        }
+    }
+}
+
+TEST(MarkovTapeTest, MachineCopyKeepsTape) {
+    MarkovProgram program;
+    program.addRule(MarkovRule("a", "bb"));
+    MarkovMachine machine(MarkovTapeKind::GapBuffer);
+    machine.loadProgram(program);
+    machine.loadTape("aaa");
+    machine.step();
+
+    MarkovMachine copy = machine;
+    EXPECT_EQ(copy.getTapeKind(), MarkovTapeKind::GapBuffer);
+    copy.step();
+    EXPECT_EQ(copy.getTape(), "bbbba");
+    EXPECT_EQ(machine.getTape(), "bbaa");
+    machine = copy;
+    EXPECT_EQ(machine.getTape(), "bbbba");
+}
@@ -0,0 +1,230 @@
+#include <gtest/gtest.h>
+#include "../src/MarkovMachine.h"
+#include "../src/MarkovTrace.h"
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+class MarkovTraceTest : public ::testing::Test {
+protected:
+    MarkovProgram program;
+    vector<string> states;
+
+    // Унарное сложение с маркером: ленты на всех шагах разные
+    void SetUp() override {
+        program.addRule(MarkovRule("*|", "|*"));
+        program.addRule(MarkovRule("*+", "*"));
+        program.addRule(MarkovRule("*", "", true));
+
+        MarkovMachine reference;
+        reference.loadProgram(program);
+        reference.loadTape(tape());
+        states.push_back(reference.getTape());
+        while (reference.step()) {
+            states.push_back(reference.getTape());
+        }
+        states.push_back(reference.getTape());
+    }
+
+    static string tape() {
+        return "*" + string(40, '|') + "+" + string(30, '|');
+    }
+
+    size_t finalStep() const {
+        return states.size() - 1;
+    }
+};
+
+TEST_F(MarkovTraceTest, ReplaysEveryStepWhenRingIsLargeEnough) {
+    MarkovTrace trace(1024);
+    MarkovMachine machine;
+    machine.loadProgram(program);
+    machine.loadTape(tape());
+    MarkovRunOptions options;
+    options.trace = &trace;
+    MarkovRunResult result = machine.run(options);
+
+    ASSERT_EQ(result.steps, finalStep());
+    EXPECT_EQ(trace.size(), finalStep());
+    EXPECT_EQ(trace.firstReplayableStep(), 0u);
+    EXPECT_EQ(trace.lastStep(), finalStep());
+    for (size_t step = 0; step <= finalStep(); ++step) {
+        string replayed;
+        ASSERT_TRUE(trace.replay(program, step, replayed));
+        EXPECT_EQ(replayed, states[step]) << step;
+    }
+    const MarkovTraceRecord& last = trace.at(trace.size() - 1);
+    EXPECT_EQ(last.rule, 2u);
+    EXPECT_EQ(last.removedLength, 1u);
+    EXPECT_EQ(last.insertedLength, 0u);
+}
+
+// Позиции правок за пределами 4 ГиБ не обрезаются ни в памяти, ни в файле
+TEST_F(MarkovTraceTest, KeepsPositionsBeyond32Bits) {
+    const uint64_t position = (uint64_t(5) << 32) + 7;
+    MarkovTrace trace(8);
+    trace.begin("", 0);
+    trace.record(0, 1, position, 2, 3);
+    EXPECT_EQ(trace.at(0).position, position);
+
+    string filename = "test_trace_wide.bin";
+    ASSERT_TRUE(trace.saveToFile(filename));
+    MarkovTrace loaded(2);
+    ASSERT_TRUE(loaded.loadFromFile(filename));
+    remove(filename.c_str());
+    ASSERT_EQ(loaded.size(), 1u);
+    EXPECT_EQ(loaded.at(0).position, position);
+    EXPECT_EQ(loaded.at(0).rule, 1u);
+    EXPECT_EQ(loaded.at(0).removedLength, 2u);
+    EXPECT_EQ(loaded.at(0).insertedLength, 3u);
+}
+
+TEST_F(MarkovTraceTest, SmallRingKeepsRecentHistory) {
+    MarkovTrace trace(16);
+    MarkovMachine machine;
+    machine.loadProgram(program);
+    machine.loadTape(tape());
+    MarkovRunOptions options;
+    options.trace = &trace;
+    machine.run(options);
+
+    EXPECT_EQ(trace.size(), 16u);
+    EXPECT_GT(trace.firstReplayableStep(), 0u);
+    EXPECT_GE(trace.lastStep() - trace.firstReplayableStep(), 8u);
+    string replayed;
+    EXPECT_FALSE(trace.replay(program, 0, replayed));
+    EXPECT_FALSE(trace.replay(program, finalStep() + 1, replayed));
+
+    size_t visited = 0;
+    ASSERT_TRUE(trace.replay(program, trace.firstReplayableStep(), trace.lastStep(),
+                             [&](uint64_t step, const string& state) {
+                                 EXPECT_EQ(state, states[step]) << step;
+                                 ++visited;
+                             }));
+    EXPECT_EQ(visited, trace.lastStep() - trace.firstReplayableStep() + 1);
+}
+
+TEST_F(MarkovTraceTest, StepLimitedRunsStartNewTrace) {
+    MarkovTrace trace(64);
+    MarkovMachine machine;
+    machine.loadProgram(program);
+    machine.loadTape(tape());
+    MarkovRunOptions options;
+    options.trace = &trace;
+    options.maxSteps = 10;
+    machine.run(options);
+    options.maxSteps = 5;
+    machine.run(options);
+
+    EXPECT_EQ(trace.firstReplayableStep(), 10u);
+    EXPECT_EQ(trace.lastStep(), 15u);
+    string replayed;
+    ASSERT_TRUE(trace.replay(program, 13, replayed));
+    EXPECT_EQ(replayed, states[13]);
+}
+
+TEST_F(MarkovTraceTest, SaveAndLoad) {
+    MarkovTrace trace(32);
+    MarkovMachine machine;
+    machine.loadProgram(program);
+    machine.loadTape(tape());
+    MarkovRunOptions options;
+    options.trace = &trace;
+    machine.run(options);
+
+    string filename = "test_trace.bin";
+    ASSERT_TRUE(trace.saveToFile(filename));
+    MarkovTrace loaded(2);
+    ASSERT_TRUE(loaded.loadFromFile(filename));
+    remove(filename.c_str());
+
+    EXPECT_EQ(loaded.capacity(), 32u);
+    EXPECT_EQ(loaded.size(), trace.size());
+    EXPECT_EQ(loaded.firstReplayableStep(), trace.firstReplayableStep());
+    EXPECT_EQ(loaded.lastStep(), trace.lastStep());
+    for (uint64_t step = loaded.firstReplayableStep(); step <= loaded.lastStep(); ++step) {
+        string replayed;
+        ASSERT_TRUE(loaded.replay(program, step, replayed));
+        EXPECT_EQ(replayed, states[step]);
+    }
+    EXPECT_FALSE(loaded.loadFromFile("missing_trace.bin"));
+}
+
+TEST_F(MarkovTraceTest, LoadRejectsCorruptFile) {
+    MarkovTrace trace(32);
+    MarkovMachine machine;
+    machine.loadProgram(program);
+    machine.loadTape(tape());
+    MarkovRunOptions options;
+    options.trace = &trace;
+    machine.run(options);
+
+    string filename = "test_trace_corrupt.bin";
+    ASSERT_TRUE(trace.saveToFile(filename));
+    string bytes;
+    {
+        ifstream file(filename, ios::binary);
+        bytes.assign(istreambuf_iterator<char>(file), istreambuf_iterator<char>());
+    }
+    auto loads = [&](const string& content) {
+        ofstream(filename, ios::binary) << content;
+        MarkovTrace loaded(2);
+        return loaded.loadFromFile(filename);
+    };
+    auto patched = [&](size_t offset, uint64_t value) {
+        string content = bytes;
+        memcpy(&content[offset], &value, sizeof(value));
+        return content;
+    };
+    // Заголовок: magic, version, capacity (8), recorded (16), firstStep, checkpointCount,
+    // encoding, reserved (48 байт); за ним шаг и длина первого снимка
+    EXPECT_TRUE(loads(bytes));
+    EXPECT_FALSE(loads(bytes.substr(0, bytes.size() - 1)));
+    EXPECT_FALSE(loads(bytes.substr(0, 40)));
+    EXPECT_FALSE(loads(patched(8, uint64_t(1) << 60)));
+    EXPECT_FALSE(loads(patched(8, uint64_t(1) << 60).substr(0, 16) + string(8, '\xff') + bytes.substr(24)));
+    EXPECT_FALSE(loads(patched(56, uint64_t(1) << 60)));
+    EXPECT_FALSE(loads(patched(56, UINT64_MAX)));
+    remove(filename.c_str());
+}
+
+TEST_F(MarkovTraceTest, SaveAndLoadPartlyFilledRing) {
+    MarkovTrace trace(1 << 16);
+    MarkovMachine machine;
+    machine.loadProgram(program);
+    machine.loadTape(tape());
+    MarkovRunOptions options;
+    options.trace = &trace;
+    machine.run(options);
+
+    string filename = "test_trace_partial.bin";
+    ASSERT_TRUE(trace.saveToFile(filename));
+    MarkovTrace loaded(2);
+    ASSERT_TRUE(loaded.loadFromFile(filename));
+    remove(filename.c_str());
+    EXPECT_EQ(loaded.size(), trace.size());
+    EXPECT_EQ(loaded.firstReplayableStep(), 0u);
+    for (uint64_t step = 0; step <= finalStep(); ++step) {
+        string replayed;
+        ASSERT_TRUE(loaded.replay(program, step, replayed));
+        EXPECT_EQ(replayed, states[step]);
+    }
+}
+
+TEST_F(MarkovTraceTest, ReplayRejectsOtherProgram) {
+    MarkovTrace trace(64);
+    MarkovMachine machine;
+    machine.loadProgram(program);
+    machine.loadTape(tape());
+    MarkovRunOptions options;
+    options.trace = &trace;
+    options.maxSteps = 5;
+    machine.run(options);
+
+    MarkovProgram other;
+    other.addRule(MarkovRule("*|", "|"));
+    string replayed;
+    EXPECT_FALSE(trace.replay(other, 5, replayed));
+}
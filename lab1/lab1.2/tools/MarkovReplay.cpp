@@ -0,0 +1,36 @@
+#include "../src/MarkovMachine.h"
+#include "../src/MarkovTrace.h"
+#include <cstdlib>
+#include <iostream>
+
+// Восстановление ленты по трассе: MarkovReplay <программа> <трасса> [шаг].
+// Программа — файл MarkovMachine::saveToFile, лента из него не используется.
+// Без шага печатает все шаги, которые можно восстановить, в формате run(true)
+int main(int argc, char* argv[]) {
+    if (argc < 3 || argc > 4) {
+        cerr << "Usage: " << argv[0] << " <program> <trace> [step]" << endl;
+        return 2;
+    }
+    MarkovMachine machine;
+    machine.loadFromFile(argv[1]);
+    MarkovTrace trace(2);
+    if (!trace.loadFromFile(argv[2])) {
+        cerr << "Cannot read trace " << argv[2] << endl;
+        return 1;
+    }
+
+    uint64_t first = trace.firstReplayableStep();
+    uint64_t last = trace.lastStep();
+    if (argc == 4) {
+        first = last = strtoull(argv[3], nullptr, 10);
+    }
+    bool replayed = trace.replay(machine.getProgram(), first, last, [](uint64_t step, const string& tape) {
+        cout << "Step: " << step << ", Tape: " << tape << endl;
+    });
+    if (!replayed) {
+        cerr << "Steps " << first << ".." << last << " are not in the trace ("
+             << trace.firstReplayableStep() << ".." << trace.lastStep() << ")" << endl;
+        return 1;
+    }
+    return 0;
+}